@@ -0,0 +1,183 @@
+// bench_order_id_hash.cpp
+//
+// Compares order_id_key hashers on real order IDs: raw hashing speed,
+// robin_hood insert/lookup throughput, and how evenly the hashes spread.
+//
+// Usage: bench-order-id-hash [events_file]
+//   events_file defaults to the client's replay file. Each JSON line with
+//   an "order_id" contributes one key, truncated exactly as client.cpp does.
+//   Without the file, uuid-style and sequential synthetic IDs are used.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include "robin_hood.h"
+#include "types.h"
+
+using json = nlohmann::json;
+using namespace std::chrono;
+
+// Same as order_id_hasher built with ORDER_ID_HASH_CRC32C
+#if defined(__SSE4_2__)
+struct order_id_crc32c_hasher {
+   size_t operator()(const order_id_key& key) const {
+      uint64_t w[2];
+      std::memcpy(w, key.order_id, 16);
+      const uint64_t crc = __builtin_ia32_crc32di(__builtin_ia32_crc32di(0, w[0]), w[1]);
+      return static_cast<size_t>(crc * 0x9e3779b97f4a7c15ull);
+   }
+};
+#endif
+
+// Byte-wise compare, as order_id_key used before
+struct order_id_memcmp_eq {
+   bool operator()(const order_id_key& a, const order_id_key& b) const {
+      return std::memcmp(a.order_id, b.order_id, ORDER_ID_LEN) == 0;
+   }
+};
+
+static order_id_key to_key(const std::string& s) {
+   order_id_key k;
+   std::memset(k.order_id, 0, ORDER_ID_LEN);
+   std::memcpy(k.order_id, s.data(), std::min(s.size(), size_t(ORDER_ID_LEN - 1)));
+   return k;
+}
+
+static std::vector<order_id_key> load_ids(const std::string& path) {
+   std::vector<order_id_key> ids;
+   std::ifstream in(path);
+   std::string line;
+   while (std::getline(in, line)) {
+      if (line.empty()) continue;
+      json j;
+      try { j = json::parse(line); } catch (...) { continue; }
+      if (j.contains("order_id") && j["order_id"].is_string())
+         ids.push_back(to_key(j["order_id"].get<std::string>()));
+   }
+   return ids;
+}
+
+static std::vector<order_id_key> synthetic_ids(size_t n) {
+   std::vector<order_id_key> ids;
+   ids.reserve(n);
+   std::mt19937_64 rng(20250416);
+   char hex[33];
+   for (size_t i = 0; i < n / 2; ++i) {
+      // uuid4().hex, as create_trade_log.py generates
+      snprintf(hex, sizeof hex, "%016llx%016llx",
+               (unsigned long long)rng(), (unsigned long long)rng());
+      ids.push_back(to_key(hex));
+   }
+   for (size_t i = 0; i < n - n / 2; ++i) {
+      // dense sequential IDs: the worst case for weak mixing
+      ids.push_back(to_key(std::to_string(100000000 + i)));
+   }
+   return ids;
+}
+
+static double ns_per(steady_clock::duration d, size_t ops) {
+   return duration_cast<nanoseconds>(d).count() / double(ops);
+}
+
+template <class Hasher, class Eq = std::equal_to<order_id_key>>
+static void run(const char* name, const std::vector<order_id_key>& ids,
+                const std::vector<order_id_key>& probes) {
+   Hasher hasher;
+   const size_t n = ids.size();
+
+   // 1) raw hash throughput
+   constexpr int ROUNDS = 20;
+   uint64_t sink = 0;
+   auto t0 = steady_clock::now();
+   for (int r = 0; r < ROUNDS; ++r)
+      for (const auto& k : ids) sink += hasher(k);
+   const double hash_ns = ns_per(steady_clock::now() - t0, n * ROUNDS);
+
+   // 2) map insert + shuffled lookup throughput
+   robin_hood::unordered_map<order_id_key, uint32_t, Hasher, Eq> map;
+   t0 = steady_clock::now();
+   for (size_t i = 0; i < n; ++i) map[ids[i]] = static_cast<uint32_t>(i);
+   const double insert_ns = ns_per(steady_clock::now() - t0, n);
+
+   t0 = steady_clock::now();
+   for (int r = 0; r < ROUNDS; ++r)
+      for (const auto& k : probes) sink += map.find(k)->second;
+   const double find_ns = ns_per(steady_clock::now() - t0, probes.size() * ROUNDS);
+
+   // 3) spread: full 64-bit collisions and low-bit bucket collisions,
+   //    compared with the expectation for a uniformly random hash
+   std::unordered_set<uint64_t> full;
+   size_t buckets = 1;
+   while (buckets < map.size()) buckets <<= 1;
+   std::vector<uint32_t> load(buckets, 0);
+   for (const auto& [k, v] : map) {
+      const uint64_t h = hasher(k);
+      full.insert(h);
+      ++load[h & (buckets - 1)];
+   }
+   size_t used = 0, max_load = 0;
+   for (uint32_t l : load) { used += l != 0; max_load = std::max<size_t>(max_load, l); }
+   const double m = double(buckets), keys = double(map.size());
+   const double ideal_used = m * (1.0 - std::pow(1.0 - 1.0 / m, keys));
+
+   std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+             << std::setprecision(2)
+             << std::setw(10) << hash_ns
+             << std::setw(11) << insert_ns
+             << std::setw(11) << find_ns
+             << std::setw(10) << (map.size() - full.size())
+             << std::setw(12) << (map.size() - used)
+             << std::setw(12) << size_t(keys - ideal_used)
+             << std::setw(7) << max_load
+             << (sink == 42 ? " " : "") << "\n";
+}
+
+int main(int argc, char** argv) {
+   const std::string path = argc > 1 ? argv[1] : "../iex_python/all_events_with_users2.txt";
+   std::vector<order_id_key> ids = load_ids(path);
+   const char* source = "replay file";
+   if (ids.empty()) {
+      ids = synthetic_ids(1'000'000);
+      source = "synthetic (replay file not found)";
+   }
+
+   // de-duplicate: the replay repeats IDs for cancels/updates
+   {
+      robin_hood::unordered_set<order_id_key, order_id_fnv_hasher> seen;
+      std::vector<order_id_key> uniq;
+      uniq.reserve(ids.size());
+      for (const auto& k : ids) if (seen.insert(k).second) uniq.push_back(k);
+      ids.swap(uniq);
+   }
+
+   std::vector<order_id_key> probes = ids;
+   std::shuffle(probes.begin(), probes.end(), std::mt19937(7));
+
+   std::cout << "order IDs: " << ids.size() << " distinct, " << source << "\n\n"
+             << std::left << std::setw(10) << "hasher" << std::right
+             << std::setw(10) << "hash ns"
+             << std::setw(11) << "insert ns"
+             << std::setw(11) << "find ns"
+             << std::setw(10) << "64b coll"
+             << std::setw(12) << "bucket coll"
+             << std::setw(12) << "ideal coll"
+             << std::setw(7) << "max" << "\n";
+
+   run<order_id_fnv_hasher, order_id_memcmp_eq>("fnv1a", ids, probes);
+   run<order_id_hasher>("words", ids, probes);
+#if defined(__SSE4_2__)
+   run<order_id_crc32c_hasher>("crc32c", ids, probes);
+#endif
+   return 0;
+}
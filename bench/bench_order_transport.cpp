@@ -0,0 +1,124 @@
+// bench_order_transport.cpp
+//
+// Pushes the same number of orders from P producer threads to one
+// consumer through (a) one moodycamel::ConcurrentQueue without producer
+// tokens, as the shard workers used before, and (b) one spsc_ring per
+// producer polled round-robin, as they use now. Reports throughput and ns
+// per order for P = 1, 4 and 16.
+//
+// Usage: bench-order-transport [orders]
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "concurrentqueue.h"
+#include "spsc_ring.h"
+#include "types.h"
+
+using namespace std::chrono;
+
+// Same shape as a queued order in local_exchange
+struct item {
+   order_t order;
+   uint32_t book;
+};
+
+static constexpr size_t BATCH = 64;
+static constexpr size_t LANE_CAPACITY = 1024;
+
+static order_t sample_order() {
+   return order_t(1, "ORDER0000000001", "BNCH", order_kind::LMT, order_side::BUY,
+                  order_status::NEW, 10000, 100, false);
+}
+
+// Runs `produce(p, per_producer)` on P threads and `consume(total)` on
+// this one; returns seconds from start to the last order consumed
+template <class Produce, class Consume>
+static double run(size_t producers, size_t total, Produce produce, Consume consume) {
+   const size_t per = total / producers;
+   std::atomic<bool> go{false};
+   std::vector<std::thread> threads;
+   for (size_t p = 0; p < producers; ++p) {
+      threads.emplace_back([&, p] {
+         while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+         produce(p, per);
+      });
+   }
+   const auto t0 = steady_clock::now();
+   go.store(true, std::memory_order_release);
+   consume(per * producers);
+   const auto t1 = steady_clock::now();
+   for (auto& t : threads) t.join();
+   return duration<double>(t1 - t0).count();
+}
+
+static double bench_mpmc(size_t producers, size_t total) {
+   moodycamel::ConcurrentQueue<item> queue(4096);
+   const item it{sample_order(), 0};
+   return run(producers, total,
+      [&](size_t, size_t n) {
+         for (size_t i = 0; i < n; ++i) queue.enqueue(it);
+      },
+      [&](size_t n) {
+         item batch[BATCH];
+         for (size_t got = 0; got < n;) {
+            const size_t k = queue.try_dequeue_bulk(batch, BATCH);
+            if (k == 0) std::this_thread::yield();
+            got += k;
+         }
+      });
+}
+
+static double bench_spsc(size_t producers, size_t total) {
+   std::vector<std::unique_ptr<spsc_ring<item>>> lanes;
+   for (size_t p = 0; p < producers; ++p) lanes.push_back(std::make_unique<spsc_ring<item>>(LANE_CAPACITY));
+   const item it{sample_order(), 0};
+   return run(producers, total,
+      [&](size_t p, size_t n) {
+         spsc_ring<item>& lane = *lanes[p];
+         for (size_t i = 0; i < n; ++i) {
+            while (!lane.try_push(it)) std::this_thread::yield();
+         }
+      },
+      [&](size_t n) {
+         item batch[BATCH];
+         size_t next = 0;
+         for (size_t got = 0; got < n;) {
+            size_t k = 0;
+            for (size_t j = 0; j < lanes.size() && k < BATCH; ++j) {
+               k += lanes[(next + j) % lanes.size()]->try_pop_bulk(batch + k, BATCH - k);
+            }
+            next = (next + 1) % lanes.size();
+            if (k == 0) std::this_thread::yield();
+            got += k;
+         }
+      });
+}
+
+int main(int argc, char** argv) {
+   const size_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4'000'000;
+
+   std::cout << "orders: " << total << ", hardware threads: "
+             << std::thread::hardware_concurrency() << "\n\n";
+   std::cout << std::left << std::setw(12) << "producers"
+             << std::setw(26) << "ConcurrentQueue ns/order"
+             << std::setw(22) << "SPSC lanes ns/order" << "speedup\n";
+
+   for (size_t producers : {1, 4, 16}) {
+      const size_t n = total / producers * producers;
+      const double mpmc = bench_mpmc(producers, n) * 1e9 / n;
+      const double spsc = bench_spsc(producers, n) * 1e9 / n;
+      std::cout << std::left << std::setw(12) << producers
+                << std::setw(26) << std::fixed << std::setprecision(1) << mpmc
+                << std::setw(22) << spsc
+                << std::setprecision(2) << mpmc / spsc << "x\n";
+   }
+   return 0;
+}
@@ -0,0 +1,106 @@
+// bench_orderbook_policies.cpp
+//
+// Replays one synthetic order flow through several basic_orderbook policy
+// configurations and reports ns per operation for each, so storage and
+// sink choices can be compared on identical input.
+//
+// Usage: bench-orderbook-policies [operations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "orderbook.h"
+
+using namespace std::chrono;
+
+struct op {
+   enum kind_t : uint8_t { ADD, CANCEL, MODIFY } kind;
+   order_t order;
+};
+
+// Mixed flow around a drifting mid: mostly passive adds near the touch,
+// some marketable adds, cancels and reprices of recent orders.
+static std::vector<op> make_flow(size_t n) {
+   std::mt19937_64 rng(42);
+   std::vector<op> flow;
+   flow.reserve(n);
+   std::vector<order_t> live;
+   uint32_t mid = 10000;
+   char id[24];   // "P" + up to 20 digits; order_t keeps the first ORDER_ID_LEN bytes
+
+   for (size_t i = 0; i < n; ++i) {
+      if (i % 1000 == 0) mid = std::clamp<uint32_t>(mid + (rng() % 21) - 10, 1000, 19000);
+      const unsigned r = rng() % 100;
+      if (r < 55 || live.empty()) {
+         const bool buy = rng() & 1;
+         const bool aggressive = rng() % 10 == 0;
+         const uint32_t off = static_cast<uint32_t>(rng() % 50);
+         const uint32_t px = buy ? (aggressive ? mid + off : mid - 1 - off)
+                                 : (aggressive ? mid - off : mid + 1 + off);
+         std::snprintf(id, sizeof id, "P%014zu", i);
+         order_t o(i, id, "BNCH", order_kind::LMT, buy ? order_side::BUY : order_side::SELL,
+                   order_status::NEW, px, 1 + rng() % 100, false);
+         flow.push_back({op::ADD, o});
+         live.push_back(o);
+      } else if (r < 90) {
+         const size_t k = live.size() - 1 - rng() % std::min<size_t>(live.size(), 64);
+         flow.push_back({op::CANCEL, live[k]});
+         live[k] = live.back();
+         live.pop_back();
+      } else {
+         const size_t k = live.size() - 1 - rng() % std::min<size_t>(live.size(), 64);
+         order_t o = live[k];
+         o.qty = 1 + rng() % 100;
+         o.timestamp = i;
+         flow.push_back({op::MODIFY, o});
+      }
+   }
+   return flow;
+}
+
+template <class Book>
+static double replay(const std::vector<op>& flow) {
+   Book ob;
+   auto t0 = steady_clock::now();
+   for (const op& o : flow) {
+      order_id_key key;
+      std::memcpy(key.order_id, o.order.order_id, ORDER_ID_LEN);
+      switch (o.kind) {
+         case op::ADD:    ob.add(o.order); break;
+         case op::CANCEL: ob.cancel(key, o.order.timestamp); break;
+         case op::MODIFY: ob.modify(key, o.order); break;
+      }
+   }
+   return duration_cast<nanoseconds>(steady_clock::now() - t0).count() / double(flow.size());
+}
+
+// Best of three replays, each on a fresh book
+template <class Book>
+static void run(const char* name, const std::vector<op>& flow) {
+   double ns = replay<Book>(flow);
+   for (int i = 0; i < 2; ++i) ns = std::min(ns, replay<Book>(flow));
+   std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+             << std::setprecision(1) << std::setw(10) << ns << "\n";
+}
+
+int main(int argc, char** argv) {
+   const size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000;
+   const std::vector<op> flow = make_flow(n);
+
+   std::cout << n << " operations\n\n"
+             << std::left << std::setw(28) << "configuration" << std::right
+             << std::setw(10) << "ns/op" << "\n";
+   run<basic_orderbook<null_sink>>("dense ladder, null sink", flow);
+   run<basic_orderbook<null_sink, map_ladder>>("map ladder, null sink", flow);
+   run<basic_orderbook<logger_sink>>("dense ladder, no logger", flow);
+   return 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "thread_slot.h"
+#include "wait_strategy.h"
+
+/**
+ * Grace periods for data published through an atomic pointer and read
+ * without locks (read-copy-update).
+ *
+ * A reader brackets each access with a guard from read(): one store into
+ * the calling thread's own slot on entry and one on exit, no shared
+ * writes and no loops, so reads are wait-free and readers on different
+ * threads touch different cache lines. A writer swaps in a new version,
+ * calls synchronize(), which returns once every reader that might still
+ * see the old version has left, and then frees the old version. A writer
+ * that must not wait calls advance() instead, keeps the old version with
+ * the epoch it returned, and frees it once quiescent() says so.
+ *
+ * Why this is enough: a reader stores its epoch (seq_cst) before loading
+ * the published pointer, and a writer swaps the pointer before bumping
+ * the epoch and scanning the slots. If the scan misses a reader's store,
+ * that store, and the pointer load after it, come later in the single
+ * seq_cst order than the swap, so the reader sees the new version.
+ *
+ * Slots are indexed by thread_slot(), so each domain has one per thread.
+ * Guards on one domain must not nest.
+ */
+class epoch_domain final {
+public:
+   static constexpr size_t MAX_THREADS = MAX_THREAD_SLOTS;
+
+   class guard {
+   public:
+      explicit guard(std::atomic<uint64_t>& slot) : slot_(slot) {}
+      ~guard() { slot_.store(0, std::memory_order_release); }
+      guard(const guard&) = delete;
+      guard& operator=(const guard&) = delete;
+
+   private:
+      std::atomic<uint64_t>& slot_;
+   };
+
+   epoch_domain() = default;
+   epoch_domain(const epoch_domain&) = delete;
+   epoch_domain& operator=(const epoch_domain&) = delete;
+
+   // Reader: hold the returned guard while using the published data
+   [[nodiscard]] guard read() {
+      std::atomic<uint64_t>& slot = slots_[thread_slot()].epoch;
+      slot.store(epoch_.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+      return guard(slot);
+   }
+
+   // Writer, after publishing: start a grace period without waiting for
+   // it. Versions replaced before the call may be freed once
+   // quiescent() holds for the returned epoch.
+   uint64_t advance() { return epoch_.fetch_add(1, std::memory_order_seq_cst) + 1; }
+
+   // Whether every reader that entered before `target` was returned by
+   // advance() has left
+   bool quiescent(uint64_t target) const {
+      for (const auto& s : slots_) {
+         const uint64_t e = s.epoch.load(std::memory_order_seq_cst);
+         if (e != 0 && e < target) return false;
+      }
+      return true;
+   }
+
+   // Writer, after publishing: wait out readers that entered before
+   void synchronize() {
+      const uint64_t target = advance();
+      for (auto& s : slots_) {
+         for (uint64_t e = s.epoch.load(std::memory_order_seq_cst); e != 0 && e < target;
+              e = s.epoch.load(std::memory_order_seq_cst)) {
+            cpu_relax();
+         }
+      }
+   }
+
+private:
+   struct alignas(64) slot_t {
+      std::atomic<uint64_t> epoch{0};   // 0: not reading
+   };
+
+   std::atomic<uint64_t> epoch_{1};
+   std::array<slot_t, MAX_THREADS> slots_{};
+};
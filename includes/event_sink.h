@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "logger.h"
+
+/**
+ * Event sink policies for basic_orderbook. A sink receives the book's
+ * price-level updates, trades, modifies and cancels as log_event_t.
+ *
+ * Every sink provides:
+ *   static constexpr bool enabled;  // false: reporting compiles away
+ *   bool active() const;            // runtime on/off (e.g. null logger)
+ *   void emit(const log_event_t&);
+ *   void emit_bulk(const log_event_t*, size_t);
+ *
+ * The book only builds events under `if constexpr (Sink::enabled)`, so a
+ * null_sink book carries no reporting code or branches at all.
+ */
+
+// Discards everything; the production no-reporting configuration
+struct null_sink {
+   static constexpr bool enabled = false;
+   bool active() const { return false; }
+   void emit(const log_event_t&) {}
+   void emit_bulk(const log_event_t*, size_t) {}
+};
+
+// Forwards to the asynchronous logger; a null logger disables reporting
+class logger_sink {
+public:
+   static constexpr bool enabled = true;
+
+   logger_sink(logger* log = nullptr) : log_(log) {}
+
+   bool active() const { return log_ != nullptr; }
+   void emit(const log_event_t& ev) { log_->push(ev); }
+   void emit_bulk(const log_event_t* evs, size_t n) { log_->push_bulk(evs, n); }
+
+private:
+   logger* log_;
+};
+
+// Calls a user function synchronously on the book thread
+class callback_sink {
+public:
+   static constexpr bool enabled = true;
+   using callback = std::function<void(const log_event_t&)>;
+
+   callback_sink() = default;
+   callback_sink(callback fn) : fn_(std::move(fn)) {}
+
+   bool active() const { return static_cast<bool>(fn_); }
+   void emit(const log_event_t& ev) { fn_(ev); }
+   void emit_bulk(const log_event_t* evs, size_t n) {
+      for (size_t i = 0; i < n; ++i) fn_(evs[i]);
+   }
+
+private:
+   callback fn_;
+};
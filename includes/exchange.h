@@ -1,9 +1,9 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
 #include <thread>
 #include <atomic>
+#include <memory>
+#include <optional>
 #include <vector>
 
 #include "types.h"
@@ -12,6 +12,9 @@
 #include "order_parser.h"
 #include "network_server.h"
 #include "market_data_publisher.h"
+#include "thread_affinity.h"
+#include "ticker_table.h"
+#include "wait_strategy.h"
 
 /**
  * The Exchange class orchestrates:
@@ -31,10 +34,21 @@ public:
     * @param logger_ptr: a pointer to an existing logger (for logging).
     * @param parser_ptr: a pointer to an order parser.
     * @param publisher_ptr: a pointer to a market data publisher.
+    * @param book_config: capacity profile applied to every book,
+    *        including the ID index each book owns.
+    * @param placement: CPUs for the book threads (keyed by symbol), the
+    *        logger and the publisher.
+    * @param queue_capacity: orders a symbol's queue may hold before it
+    *        counts as full; 0 leaves it unbounded.
+    * @param overload: what on_msg_received does when the queue is full.
     */
    Exchange(logger* logger_ptr,
          OrderParser* parser_ptr,
-         MarketDataPublisher* publisher_ptr);
+         MarketDataPublisher* publisher_ptr,
+         const orderbook_config_t& book_config = {},
+         const thread_placement_t& placement = {},
+         size_t queue_capacity = 0,
+         overload_policy overload = overload_policy::REJECT);
 
    /**
     * Destructor - stops all threads and resources cleanly.
@@ -48,50 +62,74 @@ public:
    /**
     * Creates an orderbook for the given symbol,
     * sets up a dedicated thread and a queue for incoming orders.
+    * `band` sets the symbol's base price, tick size and dense ladder width;
+    * `wait` how its thread waits while the queue is empty (hot symbols
+    * spin, cold ones park). Returns false, changing nothing, if the symbol
+    * is already added: its book and band are fixed from then on.
     */
-   void add_symbol(const char* symbol);
+   bool add_symbol(const char* symbol, const price_band& band = {},
+                   wait_policy wait = wait_policy::SPIN_PARK);
 
    /**
     * Called by NetworkServer when a raw message arrives.
-    * Parses the message using OrderParser.
-    * Dispatches the parsed order to the correct symbol's queue, if valid.
+    * Parses the message using OrderParser and dispatches the parsed
+    * order to the correct symbol's queue, if valid. The order ID is only
+    * looked up by the symbol's book, on its own thread.
+    * Returns SUCCESS once the order is queued, OVERLOADED if the queue was
+    * full and shed it, MALFORMED if it did not parse, or UNKNOWN_SYMBOL if
+    * no book trades its ticker.
     */
-   void on_msg_received(const uint8_t* data, size_t len);
+   order_result on_msg_received(const uint8_t* data, size_t len);
 
 private:
     /**
      * A lightweight struct to hold:
      *   - The actual OrderBook for a symbol.
      *   - A concurrent queue of parsed orders waiting to be processed.
-     *   - A dedicated thread that pops from the queue and calls orderbook.add/modify/cancel/execute.
+     *   - A dedicated thread that pops from the queue and calls orderbook.add/modify/cancel.
+     *   - How that thread waits while the queue is empty.
+     * The book and queue are built by the thread itself once it is pinned,
+     * so their memory is first touched on its NUMA node; `ready` is set
+     * when both exist.
      */
     struct BookThread {
-        orderbook book;
-        moodycamel::ConcurrentQueue<order_t> order_queue;
+        explicit BookThread(wait_policy wait) : waiter(wait) {}
+
+        std::optional<orderbook> book;
+        std::unique_ptr<moodycamel::ConcurrentQueue<order_t>> order_queue;
+        std::atomic<bool> ready{false};
         std::thread thread;
+        queue_waiter waiter;
     };
 
     /**
      * Thread procedure that continuously pops from bt->orderQueue
      * and processes orders on bt->book.
      * 
-     * Also calls book.execute() as needed, and can publish updates.
+     * Matching happens inside add/modify, and it can publish updates.
      */
-    void book_loop(BookThread* bt);
+    void book_loop(BookThread* bt, price_band band, int cpu);
 
     /**
      * Private helper to route an order_t to the correct BookThread queue,
      * based on order_t.ticker.
      */
-    void enqueue_order(const order_t& order);
+    order_result enqueue_order(const order_t& order);
 
 private:
    logger* logger_;
    OrderParser* parser_;
    MarketDataPublisher* publisher_;
-
-   // Map from symbol -> BookThread
-   std::unordered_map<std::string, BookThread> bookThreads_;
+   orderbook_config_t book_config_;
+   thread_placement_t placement_;
+   size_t queue_capacity_;
+   overload_policy overload_;
+
+   // Symbol -> BookThread, looked up by ticker key so routing an order
+   // builds no string. The BookThreads live in bookThreadStore_, at
+   // addresses their threads hold on to.
+   ticker_table<BookThread*> bookThreads_;
+   std::vector<std::unique_ptr<BookThread>> bookThreadStore_;
 
    // Flag controlling whether threads are running
    std::atomic<bool> running_;
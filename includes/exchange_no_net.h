@@ -55,9 +55,8 @@ public:
          }
       }
 
-      // For demonstration, do synchronous add/execute:
+      // For demonstration, do a synchronous add (matches on arrival):
       books_.at(symbol).book->add(order);
-      books_.at(symbol).book->execute();
    }
 
    void stop_all() {
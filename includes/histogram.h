@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Power-of-two histogram of sizes, written by one thread and readable from
+ * any. Bin k counts values in [2^k, 2^(k+1)); the last bin also takes
+ * everything larger. Zero is not recorded.
+ *
+ * Counters are relaxed atomics: record() is a plain increment on x86 and a
+ * reader sees each bin's count at some recent point, not a consistent
+ * snapshot across bins.
+ */
+class log2_histogram final {
+public:
+   static constexpr size_t BINS = 16;
+   using snapshot_t = std::array<uint64_t, BINS>;
+
+   void record(size_t value) {
+      if (value == 0) return;
+      const size_t bin = std::bit_width(value) - 1;
+      auto& c = counts_[bin < BINS ? bin : BINS - 1];
+      c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   }
+
+   snapshot_t snapshot() const {
+      snapshot_t out{};
+      for (size_t i = 0; i < BINS; ++i) out[i] = counts_[i].load(std::memory_order_relaxed);
+      return out;
+   }
+
+   // Adds this histogram's current counts into `into`
+   void accumulate(snapshot_t& into) const {
+      for (size_t i = 0; i < BINS; ++i) into[i] += counts_[i].load(std::memory_order_relaxed);
+   }
+
+   // Smallest value bin `i` counts
+   static constexpr size_t bin_floor(size_t i) { return size_t{1} << i; }
+
+private:
+   std::array<std::atomic<uint64_t>, BINS> counts_{};
+};
@@ -4,54 +4,301 @@
 #include <string>
 #include <unordered_map>
 #include <thread>
+#include <array>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include "types.h"
+#include "histogram.h"
 #include "orderbook.h"
-#include "concurrentqueue.h"
+#include "epoch.h"
 #include "order_parser.h"
+#include "shard_map.h"
+#include "spsc_ring.h"
+#include "thread_slot.h"
+#include "ticker_table.h"
+#include "thread_affinity.h"
+#include "wait_strategy.h"
 // #include "network_server.h"
 // #include "market_data_publisher.h"
 
 /**
- * Exchange class now uses one thread per bucket of tickers.
+ * Shard worker tuning. Workers are labelled by index ("0", "1", ...) in
+ * worker_wait and placement.
+ */
+struct exchange_options_t {
+   // Symbol -> worker assignment, and with it the number of workers.
+   // Load one saved by a previous session with shard_map::load(), or
+   // compute one from measured rates with shard_map::balance().
+   shard_map shards;
+
+   // Most orders a worker takes off its queue and applies as one
+   // batch. Smaller caps bound how long the last order of a burst waits
+   // behind the others; larger ones amortise the queue further.
+   size_t max_batch = 64;
+
+   // How an idle worker waits for orders, by default and for individual
+   // workers, so hot workers can spin while cold ones park.
+   wait_policy wait = wait_policy::SPIN_PARK;
+   std::unordered_map<std::string, wait_policy> worker_wait;
+
+   // CPU pinning for workers and the logger thread; publisher_cpu is
+   // unused here
+   thread_placement_t placement;
+
+   // Orders each gateway -> worker lane holds. A lane is allocated by
+   // the worker the first time a thread sends to it.
+   size_t lane_capacity = 1024;
+
+   // Orders a worker may have queued over all its lanes before it counts
+   // as full, by default and per worker; 0 leaves only the lane bound.
+   // The worker measures its depth each time it polls, so the limit can
+   // be overshot by what arrives between two polls.
+   size_t shard_capacity = 0;
+   std::unordered_map<std::string, size_t> worker_capacity;
+
+   // When a lane or shard is full. Orders held during a migration are
+   // not subject to it.
+   overload_policy overload = overload_policy::REJECT;
+};
+
+/**
+ * Per-worker queue accounting, for export.
+ */
+struct shard_stats_t {
+   uint64_t depth;              // orders queued at the last poll
+   uint64_t depth_high_water;   // most ever seen queued at a poll
+   uint64_t rejected;           // orders shed with OVERLOADED
+};
+
+/**
+ * Exchange with a fixed pool of shard workers, each owning the books of
+ * the symbols the shard map assigns to it. migrate() and rebalance() move
+ * books between workers while orders keep flowing.
  */
 class Exchange {
 public:
+   /**
+    * `book_config` is the capacity profile applied to every book,
+    * including the ID index each book owns.
+    */
    Exchange(logger* logger_ptr,
-            OrderParser* parser_ptr);
+            OrderParser* parser_ptr,
+            const orderbook_config_t& book_config = {},
+            const exchange_options_t& options = {});
    ~Exchange();
 
+   // start() launches the workers of symbols registered so far; orders
+   // sent before it wait in their lanes. stop() ends and joins them.
    void start();
    void stop();
 
    /**
-    * Registers a symbol into its bucket.  Spawns the bucket‐thread
-    * on first symbol for that bucket.
+    * Registers a symbol with its worker.  Spawns the worker thread
+    * on first symbol for that worker (at start() if not yet running).  `band` lays out the symbol's
+    * dense price ladder and tick size.  Books are built by their worker
+    * when the symbol's first order arrives; symbols never registered get
+    * the default band.
+    * A symbol's band is fixed once it is registered or has received an
+    * order (its book may be built by then), so add_symbol() returns false
+    * and changes nothing if either has happened; it returns true once the
+    * symbol is registered with `band`.
+    */
+   bool add_symbol(const char* symbol, const price_band& band = {});
+
+   // add_symbol() for each (symbol, band), publishing the routing table
+   // once for all of them. Returns how many were registered; the rest are
+   // skipped as add_symbol() would refuse them, as are repeats.
+   size_t add_symbols(const std::vector<std::pair<std::string, price_band>>& symbols);
+
+   /**
+    * Parse incoming raw message and route it into its worker's queue.
+    * Takes no lock: the route comes from the published routing table and
+    * the order ID is only looked up by the book that owns it, on its
+    * worker.
+    * Returns SUCCESS once the order is queued (matching results, including
+    * duplicate IDs, go to the logger), OVERLOADED if its shard shed it, or
+    * MALFORMED if it did not parse.
+    */
+   order_result on_msg_received(const uint8_t* data, size_t len);
+
+   /**
+    * Moves `symbol`'s book to worker `to` at a safe point: new orders for
+    * the symbol are held back, the current worker drains what it already
+    * has and hands the book over, then the held orders follow it. Other
+    * symbols are not paused. Blocks until the move is done; returns false
+    * if the exchange is stopped or `to` is out of range.
     */
-   void add_symbol(const char* symbol);
+   bool migrate(const std::string& symbol, uint32_t to);
 
    /**
-    * Parse incoming raw message and route into the correct bucket queue.
+    * Plans moves from the order counts seen since the previous call
+    * (shard_map::plan_moves) and performs them. Returns how many symbols
+    * were moved.
     */
-   void on_msg_received(const uint8_t* data, size_t len);
+   size_t rebalance(double tolerance = 0.1, size_t max_moves = 4);
+
+   // Orders applied per symbol since the last rebalance(), as counted by
+   // the workers (orders still queued are not in it yet)
+   std::vector<symbol_load> symbol_loads() const;
+
+   // The live assignment, including any migrations; save() it to seed the
+   // next session
+   shard_map current_shards() const;
+
+   /**
+    * Distribution of batch sizes taken off the queues, summed over all
+    * workers (bin k counts batches of 2^k .. 2^(k+1)-1 orders).
+    */
+   log2_histogram::snapshot_t batch_size_histogram() const;
+
+   // Queue depth and shedding per worker, indexed by worker
+   std::vector<shard_stats_t> shard_stats() const;
 
 private:
-   struct BucketThread {
-      std::unordered_map<std::string, orderbook> books;
-      moodycamel::ConcurrentQueue<order_t> order_queue;
+   // An order on a worker's queue, with the index of its book (the
+   // symbol's route) resolved by the producer
+   struct queued_order_t {
+      order_t order;
+      uint32_t book;
+   };
+
+   using lane_t = spsc_ring<queued_order_t>;
+   struct route_t;
+
+   // Work handed to a worker between batches
+   struct control_t {
+      enum class kind : uint8_t { RELEASE, ADOPT, LANE };
+      kind what;
+      uint32_t book;                                      // LANE: the thread slot
+      std::unique_ptr<orderbook> built;                   // ADOPT: the book
+      std::vector<order_t> held;                          // ADOPT: then these
+      std::promise<std::unique_ptr<orderbook>> done;      // RELEASE: the book
+   };
+
+   struct ShardWorker {
+      ShardWorker(uint32_t index, wait_policy policy) : index(index), waiter(policy) {}
+      ~ShardWorker() {
+         for (auto& lane : lanes) delete lane.load();
+      }
+
+      const uint32_t index;   // in workers_
+
+      // One SPSC lane per sending thread, indexed by its thread_slot().
+      // The worker builds a lane when the thread first sends, so the ring
+      // is first touched on the worker's NUMA node; a thread sending while
+      // the exchange is not running builds its own. The worker polls
+      // lanes [0, lane_count) round-robin.
+      std::array<std::atomic<lane_t*>, MAX_THREAD_SLOTS> lanes{};
+      std::atomic<size_t> lane_count{0};
+
+      // Books are built by the worker after it is pinned, so their memory
+      // is first touched on that thread's NUMA node (a migrated book
+      // keeps the pages it already has). `ready` is set once the thread
+      // is placed; books are only ever touched by the worker.
+      std::atomic<bool> ready{false};
+      std::vector<std::unique_ptr<orderbook>> books;   // by book index
+      std::vector<route_t*> routes;                    // by book index, for counting
+
+      // Overload: producers compare the worker's last measured depth
+      // against capacity (0: no shard limit); rejected is only written
+      // when an order is shed
+      size_t capacity = 0;
+      std::atomic<uint64_t> depth{0};
+      std::atomic<uint64_t> depth_high_water{0};
+      std::atomic<uint64_t> rejected{0};
+
+      std::mutex control_mutex;
+      std::vector<control_t> control;
+      std::atomic<bool> has_control{false};
+
+      std::once_flag started;
       std::thread thread;
+      queue_waiter waiter;
+      log2_histogram batch_sizes;
+   };
+
+   // A symbol's mutable routing state; lives as long as the exchange
+   struct route_t {
+      ticker_key_t ticker;
+      uint32_t book;                       // index, never reused
+      // Orders applied, written only by the worker that owns the book
+      // (load and store, no RMW); producers never touch it
+      std::atomic<uint64_t> msgs{0};
+      uint64_t msgs_at_rebalance = 0;      // registry_mutex_
+
+      // Producers that saw a frozen entry come here
+      std::mutex held_mutex;
+      uint32_t worker;
+      bool frozen = false;                 // migrating: hold new orders
+      std::vector<order_t> held;
+   };
+
+   // One symbol in a published routing table
+   struct route_entry_t {
+      route_t* route = nullptr;
+      uint32_t book = 0;
+      uint32_t worker = 0;
+      bool frozen = false;
    };
+   using routing_table_t = ticker_table<route_entry_t>;
 
-   void book_loop(BucketThread* bt);
-   void enqueue_order(const order_t& order);
+   wait_policy wait_policy_for(uint32_t worker) const;
+   ShardWorker* worker(uint32_t index);
+   orderbook& book_for(ShardWorker* w, const queued_order_t& q);
+   void count_applied(ShardWorker* w, const queued_order_t& q, size_t n);
+
+   // registry_mutex_ held: find the route, create one (unpublished), or
+   // find or create and publish; publish a table with entries changed
+   route_t* find_route_locked(ticker_key_t ticker) const;
+   route_t* new_route_locked(ticker_key_t ticker);
+   route_t* route_locked(ticker_key_t ticker);
+   void publish_locked(std::span<const route_entry_t> entries);
+   void publish_locked(route_t& route, uint32_t worker, bool frozen);
+
+   lane_t* lane_for(ShardWorker* w);
+   lane_t* install_lane(ShardWorker* w, size_t slot, lane_t* lane);
+   size_t poll_lanes(ShardWorker* w, queued_order_t* out, size_t max, size_t& next);
+   bool lanes_empty(const ShardWorker* w) const;
+   bool push(ShardWorker* w, const order_t& order, uint32_t book);
+   bool try_push(ShardWorker* w, lane_t* lane, const order_t& order, uint32_t book);
+   bool shed(ShardWorker* w, const order_t& order, uint32_t book);
+   order_result hold(route_t* route, const order_t& order);
+
+   void book_loop(ShardWorker* w, int cpu);
+   void run_control(ShardWorker* w);
+   void post(ShardWorker* w, control_t cmd);
+   order_result enqueue_order(const order_t& order);
 
    logger* logger_;
    OrderParser* parser_;
+   orderbook_config_t book_config_;
+   exchange_options_t options_;
+
+   std::vector<std::unique_ptr<ShardWorker>> workers_;
+
+   // Bands registered by add_symbol() for books not built yet
+   std::mutex bands_mutex_;
+   std::unordered_map<ticker_key_t, price_band> bands_;
+
+   // Routing is read-copy-update: producers look symbols up in the
+   // published table inside an epoch guard, without locks. Registration
+   // and migration copy the table and swap it in under registry_mutex_.
+   // The old table is retired with the epoch advance() gave, and freed by
+   // a later publish once that epoch is quiescent, so publishing never
+   // waits; only migration waits out a grace period.
+   std::atomic<const routing_table_t*> routing_;
+   epoch_domain epochs_;
+   std::vector<std::pair<uint64_t, const routing_table_t*>> retired_;   // registry_mutex_
 
-   // key = bucket label (e.g. "A", "EA-E", "SF-N", …)
-   std::unordered_map<std::string, BucketThread> bucketThreads_;
+   mutable std::mutex registry_mutex_;
+   shard_map shards_;
+   std::vector<std::unique_ptr<route_t>> routes_;   // by book index
 
    std::atomic<bool> running_{false};
 
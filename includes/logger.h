@@ -2,7 +2,10 @@
 
 #include <string>
 #include <fstream>
+#include <iosfwd>
+#include <memory>
 #include <atomic>
+#include <chrono>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -16,38 +19,96 @@ enum class log_event_kind : uint8_t {
    CANCEL
 };
 
+// Orders are named by their external ID, copied in when the event is
+// built, so an event never refers back to book state.
 struct log_event_t {
    uint64_t timestamp;
-   char order_id[ORDER_ID_LEN];
+   order_id_key id;
    log_event_kind kind;
    uint32_t price;
    size_t qty;
    order_side side;
 
-   char order_id_secondary[ORDER_ID_LEN];
+   order_id_key id_secondary;
    uint32_t price_secondary;
    size_t qty_secondary;
    order_side side_secondary;
 
    log_event_t()
       : timestamp(0)
+      , id{}
       , kind(log_event_kind::PRICE_LEVEL_UPDATE)
       , price(0)
       , qty(0)
       , side(order_side::BUY)
+      , id_secondary{}
       , price_secondary(0)
       , qty_secondary(0)
       , side_secondary(order_side::BUY)
-   {
-      memset(order_id, 0, ORDER_ID_LEN);
-      memset(order_id_secondary, 0, ORDER_ID_LEN);
-   }
+   {}
+};
+
+enum class log_format : uint8_t {
+   JSON,     // one JSON object per line
+   BINARY    // log_file_header_t, then fixed-size log_record_t; see decode_log()
+};
+
+/**
+ * Binary log layout. A file starts with one log_file_header_t and every
+ * record after it has the same size, so a reader can seek to record i.
+ * Records carry the event's external order IDs, so a log can be decoded
+ * without the books that wrote it.
+ * Bump LOG_FORMAT_VERSION whenever log_record_t changes.
+ */
+static constexpr char LOG_MAGIC[8] = {'H', 'F', 'T', 'L', 'O', 'G', 'B', '\0'};
+static constexpr uint16_t LOG_FORMAT_VERSION = 2;
+
+struct log_file_header_t {
+   char magic[8];
+   uint16_t version;
+   uint16_t record_size;
+   uint32_t reserved;
 };
+static_assert(sizeof(log_file_header_t) == 16);
+
+struct log_record_t {
+   uint64_t timestamp;
+   uint64_t qty;
+   uint64_t qty_secondary;
+   uint32_t price;
+   uint32_t price_secondary;
+   uint8_t version;             // LOG_FORMAT_VERSION
+   log_event_kind kind;
+   order_side side;
+   order_side side_secondary;
+   uint32_t reserved;
+   char order_id[ORDER_ID_LEN];
+   char order_id_secondary[ORDER_ID_LEN];
+};
+static_assert(sizeof(log_record_t) == 72);
+
+// Record for `ev`
+log_record_t to_log_record(const log_event_t& ev);
+
+// The line (without newline) the JSON format writes for a record
+std::string log_record_to_json(const log_record_t& rec);
+
+// Rewrites a binary log as the JSON format, one line per record.
+// Returns the number of records; throws std::runtime_error on a bad
+// header, an unknown version or a truncated record.
+size_t decode_log(std::istream& in, std::ostream& out);
 
 class logger {
 public:
+   // Records written per write() in the binary format (1.25 MiB)
+   static constexpr size_t BUFFER_RECORDS = 16384;
+   // The writer flushes the file once this long has passed since its
+   // last flush, when flush() asks, and at shutdown; otherwise it only
+   // writes out full buffers
+   static constexpr std::chrono::milliseconds FLUSH_INTERVAL{100};
+
    // Constructor that opens a single log file
-   explicit logger(const std::string& filename);
+   explicit logger(const std::string& filename, log_format format = log_format::JSON);
 
    // Destructor that joins thread, closes file
    ~logger();
@@ -55,6 +116,15 @@ public:
    // Generic push of a log event
    void push(const log_event_t& event);
 
+   // Push a batch of events with a single enqueue and wakeup
+   void push_bulk(const log_event_t* events, size_t count);
+
+   // Block until every event pushed so far has been written
+   void flush();
+
+   // Pin the writer thread to logical CPU `cpu`; false if not possible
+   bool pin_to_cpu(int cpu);
+
    // Specific logging methods that orderbook.cpp calls:
    void log_price_level_update(
       uint64_t ts,
@@ -99,12 +169,27 @@ private:
    std::atomic<bool> running_;
    std::thread thread_;
 
+   log_format format_;
    std::ofstream out_file_;
+   // Binary format: records not yet written to out_file_
+   std::unique_ptr<log_record_t[]> buffer_;
+   size_t buffered_ = 0;
    std::mutex mutex_;
    std::condition_variable cv_;
 
+   // Events enqueued / flushed to the file, and the most any flush()
+   // caller is waiting for
+   std::atomic<uint64_t> pushed_{0};
+   std::atomic<uint64_t> written_{0};
+   std::atomic<uint64_t> flush_target_{0};
+   std::condition_variable drained_cv_;
+
    // Worker that consumes the queue
    void run();
+   // Append events in the file's format; write_buffer() hands buffered
+   // binary records to the file
+   void write_events(const log_event_t* events, size_t count);
+   void write_buffer();
    // Convert each event to a line of text/JSON, etc.
    std::string event_to_line(const log_event_t& ev);
 };
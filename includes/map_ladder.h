@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+
+#include "price_ladder.h"
+
+/**
+ * Ladder policy that keeps only occupied levels, in a std::map keyed by
+ * price. Same interface as price_ladder; levels are created on first
+ * insert and erased when they empty. Uses memory proportional to the
+ * occupied levels rather than the price range, at the cost of a tree
+ * lookup per level and an allocation per new level. Kept mainly as a
+ * baseline for benchmarking against the dense ladder.
+ */
+class map_ladder final {
+public:
+   static constexpr uint32_t NO_LEVEL = UINT32_MAX;
+
+   explicit map_ladder(order_side side, const price_band& /*band*/ = price_band{}) : side_(side) {}
+
+   price_level& operator[](uint32_t price) { return levels_[price]; }
+   const price_level& operator[](uint32_t price) const { return levels_.find(price)->second; }
+
+   // Tree nodes cannot be located without walking the tree
+   void prefetch(uint32_t) const {}
+
+   bool empty() const { return levels_.empty(); }
+
+   std::optional<uint32_t> best() const {
+      if (levels_.empty()) return std::nullopt;
+      return top();
+   }
+
+   uint32_t top() const {
+      if (levels_.empty()) return NO_LEVEL;
+      return side_ == order_side::BUY ? levels_.rbegin()->first : levels_.begin()->first;
+   }
+
+   bool reachable(uint32_t price, uint32_t limit) const {
+      return side_ == order_side::BUY ? price >= limit : price <= limit;
+   }
+
+   uint32_t next_after(uint32_t price) const {
+      if (side_ == order_side::BUY) {
+         auto it = levels_.lower_bound(price);
+         if (it == levels_.begin()) return NO_LEVEL;
+         return std::prev(it)->first;
+      }
+      auto it = levels_.upper_bound(price);
+      return it == levels_.end() ? NO_LEVEL : it->first;
+   }
+
+   // The level already exists (operator[] created it)
+   void mark_occupied(uint32_t) {}
+
+   void mark_empty(uint32_t price) { levels_.erase(price); }
+
+private:
+   std::map<uint32_t, price_level> levels_;
+   order_side side_;
+};
@@ -10,10 +10,12 @@
 #include "concurrentqueue.h"
 
 #include "types.h"
+#include "orderbook.h"
 
+// Market data events name orders by their external ID
 struct PriceLevelUpdateMD {
    uint64_t    timestamp;
-   char        order_id[ORDER_ID_LEN];
+   order_id_key id;
    uint32_t    price;
    size_t      qty;
    order_side  side;   
@@ -22,12 +24,12 @@ struct PriceLevelUpdateMD {
 struct TradeReportMD {
    uint64_t    timestamp;
 
-   char        order_id[ORDER_ID_LEN];
+   order_id_key id;
    uint32_t    price;
    size_t      qty;
    order_side  side;
 
-   char        order_id_secondary[ORDER_ID_LEN]; 
+   order_id_key id_secondary;
    uint32_t    price_secondary;
    size_t      qty_secondary;
    order_side  side_secondary;
@@ -36,12 +38,12 @@ struct TradeReportMD {
 struct ModifyMD {
    uint64_t    timestamp;
 
-   char        order_id[ORDER_ID_LEN];
+   order_id_key id;
    uint32_t    price;
    size_t      qty;
    order_side  side;
 
-   char        order_id_secondary[ORDER_ID_LEN];
+   order_id_key id_secondary;
    uint32_t    price_secondary;
    size_t      qty_secondary;
    order_side  side_secondary;
@@ -49,7 +51,7 @@ struct ModifyMD {
 
 struct CancelMD {
    uint64_t    timestamp;
-   char        order_id[ORDER_ID_LEN];
+   order_id_key id;
    uint32_t    price;
    size_t      qty;
    order_side  side;
@@ -92,6 +94,9 @@ private:
    // current state
    std::atomic<bool> running_{false};
 
+   // CPU the publishing thread is pinned to when started; -1 for none
+   int cpu_{-1};
+
 public:
    
    MarketDataPublisher(boost::asio::io_context& ctx, const std::string& multicast_ip, unsigned short port);
@@ -120,6 +125,12 @@ public:
     */
    void set_loopback(bool enable);
 
+   /**
+    * Pins the publishing thread to logical CPU `cpu` (-1: unpinned).
+    * Must be called before start().
+    */
+   void set_cpu(int cpu);
+
 private:
 
    /**
@@ -141,3 +152,24 @@ private:
    MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
 };
 
+/**
+ * basic_orderbook event sink that turns book events into market data and
+ * hands them to a MarketDataPublisher. A null publisher disables it.
+ */
+class publisher_sink {
+public:
+   static constexpr bool enabled = true;
+
+   publisher_sink(MarketDataPublisher* publisher = nullptr) : publisher_(publisher) {}
+
+   bool active() const { return publisher_ != nullptr; }
+   void emit(const log_event_t& ev);
+   void emit_bulk(const log_event_t* evs, size_t n) {
+      for (size_t i = 0; i < n; ++i) emit(evs[i]);
+   }
+
+private:
+   MarketDataPublisher* publisher_;
+};
+
+extern template class basic_orderbook<publisher_sink>;
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Three-level 64-bit occupancy bitmap over a fixed range of slots.
+ *
+ *   top_   : bit m set  <=> mid_[m]  != 0
+ *   mid_[] : bit w set  <=> leaf_[w] != 0   (w relative to its mid word)
+ *   leaf_[]: bit i set  <=> slot i is occupied
+ *
+ * Every query touches at most one word per level and resolves it with a
+ * single lzcnt/tzcnt, so finding the next occupied slot never scans empty
+ * ranges. Capacity is limited to 64^3 = 262144 slots.
+ */
+class occupancy_bitmap final {
+public:
+   static constexpr uint32_t NONE = UINT32_MAX;
+   static constexpr size_t MAX_SLOTS = 64 * 64 * 64;
+
+   explicit occupancy_bitmap(size_t slots)
+     : leaf_((slots + 63) / 64), mid_((leaf_.size() + 63) / 64) {
+      assert(slots <= MAX_SLOTS);
+   }
+
+   bool test(uint32_t i) const {
+      return (leaf_[i >> 6] >> (i & 63)) & 1;
+   }
+
+   bool empty() const { return top_ == 0; }
+
+   void set(uint32_t i) {
+      const uint32_t w = i >> 6;
+      leaf_[w] |= bit(i & 63);
+      mid_[w >> 6] |= bit(w & 63);
+      top_ |= bit(w >> 6);
+   }
+
+   void clear(uint32_t i) {
+      const uint32_t w = i >> 6;
+      leaf_[w] &= ~bit(i & 63);
+      if (leaf_[w] != 0) return;
+      mid_[w >> 6] &= ~bit(w & 63);
+      if (mid_[w >> 6] != 0) return;
+      top_ &= ~bit(w >> 6);
+   }
+
+   // Highest occupied slot, or NONE.
+   uint32_t highest() const {
+      if (top_ == 0) return NONE;
+      return highest_in_mid(msb(top_));
+   }
+
+   // Lowest occupied slot, or NONE.
+   uint32_t lowest() const {
+      if (top_ == 0) return NONE;
+      return lowest_in_mid(lsb(top_));
+   }
+
+   // Highest occupied slot strictly below i, or NONE.
+   uint32_t next_below(uint32_t i) const {
+      if (i == 0) return NONE;
+      --i;
+      const uint32_t w = i >> 6;
+      const uint64_t lw = leaf_[w] & upto(i & 63);
+      if (lw) return (w << 6) | msb(lw);
+
+      const uint32_t m = w >> 6;
+      const uint64_t mw = mid_[m] & below(w & 63);
+      if (mw) return highest_in_leaf((m << 6) | msb(mw));
+
+      const uint64_t tw = top_ & below(m);
+      if (tw) return highest_in_mid(msb(tw));
+      return NONE;
+   }
+
+   // Lowest occupied slot strictly above i, or NONE.
+   uint32_t next_above(uint32_t i) const {
+      const uint32_t w = i >> 6;
+      const uint64_t lw = leaf_[w] & above(i & 63);
+      if (lw) return (w << 6) | lsb(lw);
+
+      const uint32_t m = w >> 6;
+      const uint64_t mw = mid_[m] & above(w & 63);
+      if (mw) return lowest_in_leaf((m << 6) | lsb(mw));
+
+      const uint64_t tw = top_ & above(m);
+      if (tw) return lowest_in_mid(lsb(tw));
+      return NONE;
+   }
+
+private:
+   static constexpr uint64_t bit(uint32_t b) { return uint64_t{1} << b; }
+   // bits [0, b]
+   static constexpr uint64_t upto(uint32_t b) { return b == 63 ? ~uint64_t{0} : bit(b + 1) - 1; }
+   // bits [0, b)
+   static constexpr uint64_t below(uint32_t b) { return bit(b) - 1; }
+   // bits (b, 63]
+   static constexpr uint64_t above(uint32_t b) { return b == 63 ? 0 : ~uint64_t{0} << (b + 1); }
+
+   static uint32_t msb(uint64_t x) { return 63 - static_cast<uint32_t>(std::countl_zero(x)); }
+   static uint32_t lsb(uint64_t x) { return static_cast<uint32_t>(std::countr_zero(x)); }
+
+   uint32_t highest_in_leaf(uint32_t w) const { return (w << 6) | msb(leaf_[w]); }
+   uint32_t lowest_in_leaf(uint32_t w) const { return (w << 6) | lsb(leaf_[w]); }
+   uint32_t highest_in_mid(uint32_t m) const { return highest_in_leaf((m << 6) | msb(mid_[m])); }
+   uint32_t lowest_in_mid(uint32_t m) const { return lowest_in_leaf((m << 6) | lsb(mid_[m])); }
+
+   std::vector<uint64_t> leaf_;
+   std::vector<uint64_t> mid_;
+   uint64_t top_ = 0;
+};
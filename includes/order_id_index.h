@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#include "prefetch.h"
+#include "types.h"
+
+/**
+ * Open-addressing (linear probing) map from order_id_key to the order's
+ * order_pool node that never rehashes in one go. Node 0, which the pool
+ * never hands out, marks an empty slot and TOMBSTONE an erased one, so a
+ * slot is just the key and its node (20 bytes).
+ *
+ * Lookups probe past tombstones; inserts reuse the first one they pass.
+ * Once live keys plus tombstones pass half the table, a new table is
+ * allocated, twice the size if more than a quarter of the slots hold live
+ * keys and the same size otherwise, and every later insert moves
+ * MIGRATE_STEP buckets from the old table into it. Only live keys move,
+ * so tombstones are dropped and a table whose keys come and go stays the
+ * same size instead of growing. Until the old table is drained, lookups
+ * probe the new table and then the old one; inserts go to the new table
+ * only, and erase() tombstones the key in both. Migration always finishes
+ * long before the new table reaches its own threshold, so at most two
+ * tables exist and no single insert does more than a bounded amount of
+ * work.
+ *
+ * A drained table of the current size is kept as a spare and cleared
+ * CLEAR_STEP slots per insert, so the next same-size rebuild reuses it
+ * instead of allocating: under churn the index allocates nothing once it
+ * has reached its working size. Constructing with `expected` keys sizes
+ * the table so that many live keys leave room for tombstones (a rebuild
+ * never has to double) and allocates the spare up front.
+ *
+ * Tables come from calloc, so a fresh (empty) table is already zero and
+ * large ones are faulted in lazily rather than cleared up front.
+ */
+class order_id_index final {
+public:
+   // find() result for an absent key, and the mark of an empty slot
+   static constexpr uint32_t NONE = 0;
+   // Marks an erased slot; never a valid node
+   static constexpr uint32_t TOMBSTONE = ~uint32_t{0};
+
+   explicit order_id_index(size_t expected = 0) {
+      size_t cap = MIN_CAPACITY;
+      while (cap / 4 < expected) cap <<= 1;
+      cur_ = make_table(cap);
+      if (expected) {
+         spare_ = make_table(cap);
+         cleared_ = cap;
+      }
+   }
+
+   // non-copyable
+   order_id_index(const order_id_index&) = delete;
+   order_id_index& operator=(const order_id_index&) = delete;
+
+   // Node stored for `key`, or NONE.
+   uint32_t find(const order_id_key& key) const {
+      const size_t hash = order_id_hasher{}(key);
+      if (const slot* s = lookup(cur_, key, hash)) return s->node;
+      if (old_.slots) {
+         if (const slot* s = lookup(old_, key, hash)) return s->node;
+      }
+      return NONE;
+   }
+
+   // Store key -> node unless the key is present. Returns the existing
+   // node, or NONE if `node` was inserted.
+   uint32_t insert(const order_id_key& key, uint32_t node) {
+      migrate_some();
+      const size_t hash = order_id_hasher{}(key);
+      if (old_.slots) {
+         if (const slot* s = lookup(old_, key, hash)) return s->node;
+      }
+      slot* s = insert_slot(cur_, key, hash);
+      if (s->node != NONE && s->node != TOMBSTONE) return s->node;
+
+      if (s->node == NONE) ++used_;
+      s->key = key;
+      s->node = node;
+      ++size_;
+      if (used_ > (cur_.mask + 1) / 2 && !old_.slots) start_growth();
+      return NONE;
+   }
+
+   // Point a present key at `node`; false if the key is not present.
+   bool update(const order_id_key& key, uint32_t node) {
+      const size_t hash = order_id_hasher{}(key);
+      bool found = false;
+      if (slot* s = lookup(cur_, key, hash)) {
+         s->node = node;
+         found = true;
+      }
+      // A migrated key still has its old copy
+      if (old_.slots) {
+         if (slot* s = lookup(old_, key, hash)) {
+            s->node = node;
+            found = true;
+         }
+      }
+      return found;
+   }
+
+   // Remove `key`; false if it was not present. The slot becomes a
+   // tombstone until the table is next rebuilt.
+   bool erase(const order_id_key& key) {
+      const size_t hash = order_id_hasher{}(key);
+      bool found = false;
+      if (slot* s = lookup(cur_, key, hash)) {
+         s->node = TOMBSTONE;
+         found = true;
+      }
+      // A migrated key still has its old copy
+      if (old_.slots) {
+         if (slot* s = lookup(old_, key, hash)) {
+            s->node = TOMBSTONE;
+            found = true;
+         }
+      }
+      if (found) --size_;
+      return found;
+   }
+
+   // Start loading the slot where a probe for `key` begins
+   void prefetch(const order_id_key& key) const {
+      prefetch_for_write(&cur_.slots[order_id_hasher{}(key) & cur_.mask]);
+   }
+
+   size_t size() const { return size_; }
+   size_t capacity() const { return cur_.mask + 1; }
+   bool migrating() const { return old_.slots != nullptr; }
+
+private:
+   static constexpr size_t MIN_CAPACITY = 64;
+   static constexpr size_t MIGRATE_STEP = 16;
+   static constexpr size_t CLEAR_STEP = 64;
+
+   struct slot {
+      order_id_key key;
+      uint32_t node;
+   };
+
+   struct free_deleter {
+      void operator()(slot* p) const { std::free(p); }
+   };
+
+   struct table {
+      std::unique_ptr<slot[], free_deleter> slots;
+      size_t mask = 0;
+   };
+
+   static table make_table(size_t cap) {
+      slot* p = static_cast<slot*>(std::calloc(cap, sizeof(slot)));
+      if (!p) throw std::bad_alloc();
+      return table{std::unique_ptr<slot[], free_deleter>(p), cap - 1};
+   }
+
+   // Live slot holding `key`, or nullptr
+   static slot* lookup(const table& t, const order_id_key& key, size_t hash) {
+      for (size_t i = hash & t.mask;; i = (i + 1) & t.mask) {
+         slot* s = &t.slots[i];
+         if (s->node == NONE) return nullptr;
+         if (s->node != TOMBSTONE && s->key == key) return s;
+      }
+   }
+
+   // Live slot holding `key`, or else the first tombstone or empty slot
+   // on its probe path, where it would go
+   static slot* insert_slot(const table& t, const order_id_key& key, size_t hash) {
+      slot* reuse = nullptr;
+      for (size_t i = hash & t.mask;; i = (i + 1) & t.mask) {
+         slot* s = &t.slots[i];
+         if (s->node == NONE) return reuse ? reuse : s;
+         if (s->node == TOMBSTONE) {
+            if (!reuse) reuse = s;
+         } else if (s->key == key) {
+            return s;
+         }
+      }
+   }
+
+   void start_growth() {
+      const size_t cap = cur_.mask + 1;
+      const size_t next = size_ > cap / 4 ? cap * 2 : cap;
+      old_ = std::move(cur_);
+      if (spare_.slots && spare_.mask + 1 == next) {
+         // Normally cleared long ago; finish it if the churn outran us
+         clear_spare(next);
+         cur_ = std::move(spare_);
+      } else {
+         spare_ = table{};
+         cur_ = make_table(next);
+      }
+      used_ = 0;
+      migrated_ = 0;
+   }
+
+   // Move the next MIGRATE_STEP old buckets into the current table. Keys
+   // still live in the old table were never inserted into the current
+   // one, so each goes into the first free slot on its probe path. The
+   // drained table becomes the spare if it can serve the next rebuild;
+   // otherwise inserts clear the spare a step at a time.
+   void migrate_some() {
+      if (!old_.slots) {
+         if (spare_.slots) clear_spare(CLEAR_STEP);
+         return;
+      }
+      const size_t end = std::min(migrated_ + MIGRATE_STEP, old_.mask + 1);
+      for (; migrated_ < end; ++migrated_) {
+         const slot& from = old_.slots[migrated_];
+         if (from.node == NONE || from.node == TOMBSTONE) continue;
+         slot* to = insert_slot(cur_, from.key, order_id_hasher{}(from.key));
+         if (to->node == NONE) ++used_;
+         *to = from;
+      }
+      if (migrated_ > old_.mask) {
+         if (old_.mask == cur_.mask) {
+            spare_ = std::move(old_);
+            cleared_ = 0;
+         }
+         old_ = table{};
+      }
+   }
+
+   // Zero up to `n` more slots of the spare
+   void clear_spare(size_t n) {
+      const size_t end = std::min(cleared_ + n, spare_.mask + 1);
+      if (cleared_ >= end) return;
+      std::memset(static_cast<void*>(&spare_.slots[cleared_]), 0, (end - cleared_) * sizeof(slot));
+      cleared_ = end;
+   }
+
+   table cur_;
+   table old_;
+   table spare_;         // same size as cur_, zero below cleared_
+   size_t migrated_ = 0;
+   size_t cleared_ = 0;
+   size_t size_ = 0;   // live keys
+   size_t used_ = 0;   // live keys and tombstones in cur_
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "prefetch.h"
+#include "types.h"
+
+/**
+ * Hot part of a resting order: only what matching reads or writes, plus
+ * the intrusive links for its price level's FIFO queue. Links are pool
+ * handles rather than pointers so they stay 4 bytes. The node keeps its
+ * price so that a cancel or modify, which finds the node through the ID
+ * index, can reach its level without the cold table. Two nodes share a
+ * cache line; the wire fields (ID, ticker, kind, ...) live in the pool's
+ * cold table.
+ */
+struct alignas(32) order_node {
+   size_t qty;
+   uint64_t timestamp;
+   uint32_t price;
+   uint32_t prev;
+   uint32_t next;
+   order_side side;
+};
+static_assert(sizeof(order_node) == 32, "order_node must stay half a cache line");
+
+/**
+ * Per-book slab allocator for order_node. Nodes are addressed by a dense
+ * 32-bit handle and never move once allocated, so handles can be stored
+ * in the ID lookup and in level queues. Handle 0 is never handed out, so
+ * the ID lookup can use it to mark an empty slot. Released nodes are
+ * threaded onto a free list (through `next`) and reused before a new slab
+ * is allocated.
+ *
+ * Each hot slab has a parallel cold slab holding the order_t the node was
+ * created from. Matching never touches it; cold() is for reporting.
+ *
+ * Slabs are not zeroed on allocation. reserve() allocates them up front so
+ * acquire() never allocates below the reserved count, and can pre-fault
+ * their pages so the first orders do not take page faults either.
+ */
+class order_pool final {
+public:
+   static constexpr uint32_t NIL = UINT32_MAX;
+
+   order_pool() = default;
+
+   // non-copyable
+   order_pool(const order_pool&) = delete;
+   order_pool& operator=(const order_pool&) = delete;
+
+   // movable
+   order_pool(order_pool&&) noexcept = default;
+   order_pool& operator=(order_pool&&) noexcept = default;
+
+   order_node& operator[](uint32_t h) { return slabs_[h >> SLAB_SHIFT][h & SLAB_MASK]; }
+   const order_node& operator[](uint32_t h) const { return slabs_[h >> SLAB_SHIFT][h & SLAB_MASK]; }
+
+   const order_t& cold(uint32_t h) const { return cold_[h >> SLAB_SHIFT][h & SLAB_MASK]; }
+
+   // Start loading node `h` if it has ever been handed out
+   void prefetch(uint32_t h) const {
+      if (h != 0 && h < fresh_) prefetch_for_write(&(*this)[h]);
+   }
+
+   // Allocate slabs for at least `orders` nodes
+   void reserve(size_t orders, bool prefault = false) {
+      const size_t slabs = (orders + 1 + SLAB_MASK) >> SLAB_SHIFT;
+      slabs_.reserve(slabs);
+      cold_.reserve(slabs);
+      while (slabs_.size() < slabs) add_slab(prefault);
+   }
+
+   uint32_t acquire(const order_t& order) {
+      uint32_t h;
+      if (free_head_ != NIL) {
+         h = free_head_;
+         free_head_ = (*this)[h].next;
+      } else {
+         if ((fresh_ >> SLAB_SHIFT) == slabs_.size()) add_slab(false);
+         h = fresh_++;
+      }
+      order_node& node = (*this)[h];
+      node.qty = order.qty;
+      node.timestamp = order.timestamp;
+      node.price = order.price;
+      node.prev = NIL;
+      node.next = NIL;
+      node.side = static_cast<order_side>(order.side);
+      cold_[h >> SLAB_SHIFT][h & SLAB_MASK] = order;
+      return h;
+   }
+
+   void release(uint32_t h) {
+      (*this)[h].next = free_head_;
+      free_head_ = h;
+   }
+
+private:
+   void add_slab(bool prefault) {
+      slabs_.emplace_back(std::make_unique_for_overwrite<order_node[]>(SLAB_SIZE));
+      cold_.emplace_back(std::make_unique_for_overwrite<order_t[]>(SLAB_SIZE));
+      if (prefault) {
+         std::memset(static_cast<void*>(slabs_.back().get()), 0, SLAB_SIZE * sizeof(order_node));
+         std::memset(static_cast<void*>(cold_.back().get()), 0, SLAB_SIZE * sizeof(order_t));
+      }
+   }
+
+   static constexpr uint32_t SLAB_SHIFT = 12;
+   static constexpr uint32_t SLAB_SIZE = 1u << SLAB_SHIFT;
+   static constexpr uint32_t SLAB_MASK = SLAB_SIZE - 1;
+
+   std::vector<std::unique_ptr<order_node[]>> slabs_;
+   std::vector<std::unique_ptr<order_t[]>> cold_;
+   uint32_t free_head_ = NIL;
+   uint32_t fresh_ = 1;   // handle 0 is reserved
+};
@@ -5,14 +5,17 @@
 #endif
 
 #include <cstdint>
+#include <memory>
 #include <optional>
-#include <map>
+#include <span>
+#include <vector>
 
+#include "event_sink.h"
 #include "logger.h"
-#include "plf_hive.h"
-#include "robin_hood.h"
-
-static constexpr uint32_t MAX_PRICE = 20000;
+#include "map_ladder.h"
+#include "order_id_index.h"
+#include "order_pool.h"
+#include "price_ladder.h"
 
 enum class order_result : uint8_t {
    SUCCESS=0,
@@ -20,55 +23,174 @@ enum class order_result : uint8_t {
    ORDER_NOT_FOUND=20,
    INVALID_SIDE=30,
    INVALID_PRICE=40,
-   NO_MATCH=50
+   NO_MATCH=50,
+   WOULD_CROSS=60,
+   INSUFFICIENT_LIQUIDITY=70,
+   INVALID_STATUS=80,
+   // Gateway only: the order never reached a book
+   OVERLOADED=90,       // its queue was full and shed it
+   MALFORMED=100,       // the message did not parse
+   UNKNOWN_SYMBOL=110   // no book trades its ticker
 };
 
-struct order_location {
-   uint32_t price;
-   plf::hive<order_t>::iterator location_in_hive;
-};
+/**
+ * What enqueueing does when the order's queue (a shard, or a symbol's
+ * queue in the networked exchange) is full.
+ *   REJECT - return order_result::OVERLOADED at once; the order is dropped
+ *            and the sender can retry or cancel elsewhere.
+ *   BLOCK  - wait for the book's thread to make room. Nothing is lost, but
+ *            the gateway stalls and every order behind it waits too.
+ */
+enum class overload_policy : uint8_t { REJECT=0, BLOCK=1 };
+
+/**
+ * Limit order book for one symbol, parameterised by policy:
+ *   Sink   - where events go: null_sink, logger_sink, callback_sink, or
+ *            publisher_sink (market_data_publisher.h). With null_sink all
+ *            reporting compiles away.
+ *   Ladder - price level storage: price_ladder (dense array + occupancy
+ *            bitmap) or map_ladder (std::map of occupied levels).
+ *   Range  - valid prices: price_band (runtime, per symbol; the dense
+ *            ladder covers the band and prices outside it overflow into
+ *            a sparse map) or static_price_range<Max> (fixed 0..Max).
+ * Levels are always intrusive FIFO queues over the book's order_pool, so
+ * time priority holds in every configuration.
+ *
+ * Member definitions live in orderbook_impl.h. The configurations below
+ * are instantiated in orderbook.cpp; other combinations include
+ * orderbook_impl.h and instantiate their own.
+ */
+template <class Sink = logger_sink,
+          class Ladder = price_ladder,
+          class Range = price_band>
+class basic_orderbook final {
+public:
+   using sink_type = Sink;
+   using ladder_type = Ladder;
+   using range_type = Range;
 
-struct price_level {
-   plf::hive<order_t> orders;
-   size_t total_qty = 0;
-};
+   explicit basic_orderbook(Sink sink = Sink{}, Range range = Range{})
+     : basic_orderbook(orderbook_config_t{}, std::move(sink), std::move(range)) {}
 
-class orderbook final {
-public:
-   explicit orderbook(logger* log_instance = nullptr)
-     : log_(log_instance) {}
+   // Reserves storage for the config's capacity profile up front
+   explicit basic_orderbook(const orderbook_config_t& config,
+                            Sink sink = Sink{},
+                            Range range = Range{});
 
    // non-copyable
-   orderbook(const orderbook&) = delete;
-   orderbook& operator=(const orderbook&) = delete;
+   basic_orderbook(const basic_orderbook&) = delete;
+   basic_orderbook& operator=(const basic_orderbook&) = delete;
 
    // movable
-   orderbook(orderbook&&) = default;
-   orderbook& operator=(orderbook&&) noexcept = default;
-
-   ~orderbook() = default;
-
-   // Core functionality
+   basic_orderbook(basic_orderbook&&) = default;
+   basic_orderbook& operator=(basic_orderbook&&) noexcept = default;
+
+   // Core functionality. add() and modify() cross the incoming order
+   // against the opposite side first and rest only the remainder, so the
+   // book is never left crossed; execute() is kept for callers that
+   // build a crossed book by other means and is a no-op otherwise.
+   // Market orders (order_kind::MKT) and IOC/FOK orders trade what is
+   // available immediately and never rest or enter the ID lookup; add()
+   // returns NO_MATCH when nothing traded and INSUFFICIENT_LIQUIDITY when a
+   // FOK cannot be filled in full. Post-only orders that would take
+   // liquidity are rejected with WOULD_CROSS. Prices the Range rejects
+   // (off a band's tick grid, above a static range's Max) return
+   // INVALID_PRICE. modify() shrinks an order in place, keeping its queue
+   // position, when only its size goes down; price/side changes and size
+   // increases lose priority. A modify to size 0 cancels the order.
+   // Orders are found by their external ID through the book's ID index,
+   // which maps it straight to the order's pool node. An ID is forgotten
+   // once its order fills or is cancelled, so it may be sent again.
+   // Events carry the timestamp of the request that caused them: the
+   // incoming order's, or for cancel() the one passed in.
    order_result add(const order_t& order);
    order_result modify(const order_id_key& id, const order_t& new_order);
-   order_result cancel(const order_id_key& id);
+   order_result cancel(const order_id_key& id, uint64_t timestamp);
    void execute();
 
+   // Gateway dispatch on order_t::status: NEW adds, CANCELLED cancels and
+   // PARTIALLY_FILLED/FILLED modify the order with the same ID. Other
+   // statuses return INVALID_STATUS.
+   order_result apply(const order_t& order);
+
+   // Same results as apply() on each order in turn, applied in order.
+   // While applying it prefetches a few orders ahead: ID index slots,
+   // target levels, resting nodes and their queue neighbours, so the
+   // cache misses of a burst overlap instead of being paid one order at
+   // a time. Events are handed to the sink in one emit_bulk() when the
+   // batch ends. `results`, if not empty, receives one result per order
+   // and must be as long as `orders`.
+   void apply_batch(std::span<const order_t> orders, std::span<order_result> results = {});
+
    std::optional<uint32_t> best_bid() const;
    std::optional<uint32_t> best_ask() const;
    bool contains(const order_id_key& id) const;
 
-private:
-   // Lazy price buckets
-   std::map<uint32_t, price_level> bids_;
-   std::map<uint32_t, price_level> asks_;
-
-   // Lookup orders by ID
-   robin_hood::unordered_map<order_id_key, order_location, order_id_hasher> order_id_lookup_;
+   // Wire view of a resting order with its current quantity, if resting.
+   // Reads the cold table, so it is for reporting rather than matching.
+   std::optional<order_t> resting_order(const order_id_key& id) const;
 
-   // Optional logger
-   logger* log_ = nullptr;
+   const order_id_index& ids() const { return ids_; }
+   const Range& range() const { return range_; }
 
-   // Helpers to maintain best price logic moved into implementation
-   void log_event(const log_event_t& event);
+private:
+   // How many orders ahead of the one being applied apply_batch() starts
+   // each prefetch stage; each stage waits on the lines of the one before
+   static constexpr size_t PREFETCH_AHEAD_IDS = 12;
+   static constexpr size_t PREFETCH_AHEAD_NODES = 8;
+   static constexpr size_t PREFETCH_AHEAD_LINKS = 4;
+
+   // Valid prices; the ladders are laid out from it
+   Range range_;
+
+   // Price levels, one ladder per side
+   Ladder bids_;
+   Ladder asks_;
+
+   // Storage for every resting order; levels link nodes by handle
+   order_pool pool_;
+
+   // ID -> pool node of each resting order
+   order_id_index ids_;
+
+   // Event sink
+   Sink sink_;
+
+   // Trades from the current add/modify, handed to the sink in one batch.
+   // During apply_batch() every event is held here until the batch ends.
+   std::vector<log_event_t> pending_;
+   bool deferring_ = false;
+
+   // True if events are being reported; constant false for disabled sinks
+   bool reporting() const {
+      if constexpr (Sink::enabled) return sink_.active();
+      else return false;
+   }
+
+   void report(log_event_kind kind, uint64_t ts,
+               const order_id_key& id, uint32_t price, size_t qty, order_side side,
+               const order_id_key& id2 = {},
+               uint32_t price2 = 0, size_t qty2 = 0, order_side side2 = order_side::BUY);
+   size_t match(const order_t& order, uint32_t limit);
+   order_result take(const order_t& order, uint32_t limit);
+   bool would_cross(order_side side, uint32_t limit) const;
+   size_t depth_within(order_side side, uint32_t limit, size_t want) const;
+   void flush_pending();
+   void prefetch_ids(const order_t& o);
+   uint32_t prefetch_resting(const order_t& o);
+   void prefetch_links(uint32_t node);
+   uint32_t rest(const order_t& order, size_t qty);
+   void unrest(uint32_t node);
+   void retire(uint32_t node);
 };
+
+// Prebuilt configurations (see orderbook.cpp)
+extern template class basic_orderbook<logger_sink>;
+extern template class basic_orderbook<null_sink>;
+extern template class basic_orderbook<callback_sink>;
+extern template class basic_orderbook<logger_sink, map_ladder>;
+extern template class basic_orderbook<null_sink, map_ladder>;
+
+// The default book: dense ladder over a price band, reporting to an
+// optional logger
+using orderbook = basic_orderbook<>;
@@ -0,0 +1,437 @@
+#pragma once
+
+// Member definitions for basic_orderbook. Included by orderbook.cpp for
+// the prebuilt configurations, and by code that instantiates others.
+
+#include "orderbook.h"
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <chrono>
+#include <algorithm>
+
+namespace detail {
+inline uint64_t book_time_ns() {
+   using namespace std::chrono;
+   return static_cast<uint64_t>(
+      duration_cast<nanoseconds>(
+         steady_clock::now().time_since_epoch()
+      ).count()
+   );
+}
+
+inline order_id_key id_of(const order_t& order) {
+   order_id_key key;
+   std::memcpy(key.order_id, order.order_id, ORDER_ID_LEN);
+   return key;
+}
+}
+
+template <class Sink, class Ladder, class Range>
+basic_orderbook<Sink, Ladder, Range>::basic_orderbook(const orderbook_config_t& config, Sink sink,
+                                                      Range range)
+  : range_(std::move(range)),
+    bids_(order_side::BUY, range_.band()), asks_(order_side::SELL, range_.band()),
+    ids_(config.expected_order_ids), sink_(std::move(sink)) {
+   pool_.reserve(config.expected_live_orders, config.prefault);
+   pending_.reserve(config.expected_fills);
+}
+
+template <class Sink, class Ladder, class Range>
+bool basic_orderbook<Sink, Ladder, Range>::contains(const order_id_key& id) const {
+   return ids_.find(id) != order_id_index::NONE;
+}
+
+template <class Sink, class Ladder, class Range>
+std::optional<order_t> basic_orderbook<Sink, Ladder, Range>::resting_order(const order_id_key& id) const {
+   const uint32_t node = ids_.find(id);
+   if (node == order_id_index::NONE) return std::nullopt;
+   order_t order = pool_.cold(node);
+   order.qty = pool_[node].qty;
+   return order;
+}
+
+template <class Sink, class Ladder, class Range>
+void basic_orderbook<Sink, Ladder, Range>::report(log_event_kind kind, uint64_t ts,
+                  const order_id_key& id, uint32_t price, size_t qty, order_side side,
+                  const order_id_key& id2,
+                  uint32_t price2, size_t qty2, order_side side2) {
+   log_event_t ev;
+   ev.timestamp = ts;
+   ev.kind = kind;
+   ev.id = id;
+   ev.price = price;
+   ev.qty = qty;
+   ev.side = side;
+   ev.id_secondary = id2;
+   ev.price_secondary = price2;
+   ev.qty_secondary = qty2;
+   ev.side_secondary = side2;
+   if (deferring_) pending_.push_back(ev);
+   else            sink_.emit(ev);
+}
+
+template <class Sink, class Ladder, class Range>
+std::optional<uint32_t> basic_orderbook<Sink, Ladder, Range>::best_bid() const {
+   return bids_.best();
+}
+
+template <class Sink, class Ladder, class Range>
+std::optional<uint32_t> basic_orderbook<Sink, Ladder, Range>::best_ask() const {
+   return asks_.best();
+}
+
+// Cross an incoming order against the opposite side up to `limit`, oldest
+// order first at each price, and return the quantity left unfilled.
+// Trades carry the incoming order's timestamp and are buffered in pending_.
+template <class Sink, class Ladder, class Range>
+size_t basic_orderbook<Sink, Ladder, Range>::match(const order_t& order, uint32_t limit) {
+   const bool is_buy = static_cast<order_side>(order.side) == order_side::BUY;
+   const bool is_market = static_cast<order_kind>(order.kind) == order_kind::MKT;
+   auto& opposite = (is_buy ? asks_ : bids_);
+   size_t remaining = order.qty;
+
+   while (remaining > 0) {
+      auto best = opposite.best();
+      if (!best || (is_buy ? *best > limit : *best < limit)) break;
+
+      price_level& level = opposite[*best];
+      const uint32_t h = level.head;
+      order_node& resting = pool_[h];
+      const size_t m = std::min(remaining, resting.qty);
+      remaining -= m;
+      resting.qty -= m;
+      level.total_qty -= m;
+
+      if (reporting()) {
+         // A market order has no price of its own; report the fill price
+         const uint32_t own_px = is_market ? *best : order.price;
+         log_event_t& ev = pending_.emplace_back();
+         ev.timestamp = order.timestamp;
+         ev.kind = log_event_kind::TRADE_REPORT;
+         const order_id_key in_id = detail::id_of(order);
+         const order_id_key rest_id = detail::id_of(pool_.cold(h));
+         ev.id = is_buy ? in_id : rest_id;
+         ev.price = is_buy ? own_px : *best;
+         ev.qty = m;
+         ev.side = order_side::BUY;
+         ev.id_secondary = is_buy ? rest_id : in_id;
+         ev.price_secondary = is_buy ? *best : own_px;
+         ev.qty_secondary = m;
+         ev.side_secondary = order_side::SELL;
+      }
+
+      if (resting.qty == 0) retire(h);
+   }
+   return remaining;
+}
+
+template <class Sink, class Ladder, class Range>
+void basic_orderbook<Sink, Ladder, Range>::flush_pending() {
+   if (deferring_ || pending_.empty()) return;
+   sink_.emit_bulk(pending_.data(), pending_.size());
+   pending_.clear();
+}
+
+// Append `qty` of order to the back of its level's queue; returns the
+// node, which the caller records in the ID index.
+template <class Sink, class Ladder, class Range>
+uint32_t basic_orderbook<Sink, Ladder, Range>::rest(const order_t& order, size_t qty) {
+   auto& ladder = (static_cast<order_side>(order.side) == order_side::BUY ? bids_ : asks_);
+   price_level& level = ladder[order.price];
+   const bool was_empty = level.empty();
+   const uint32_t node = pool_.acquire(order);
+   pool_[node].qty = qty;
+   level.push_back(pool_, node);
+   if (was_empty) ladder.mark_occupied(order.price);
+   return node;
+}
+
+// Unlink a resting order from its level and return its node to the pool.
+template <class Sink, class Ladder, class Range>
+void basic_orderbook<Sink, Ladder, Range>::unrest(uint32_t node) {
+   const order_node& n = pool_[node];
+   auto& ladder = (n.side == order_side::BUY ? bids_ : asks_);
+   const uint32_t price = n.price;
+   price_level& level = ladder[price];
+   level.unlink(pool_, node);
+   if (level.empty()) ladder.mark_empty(price);
+   pool_.release(node);
+}
+
+// Remove a done (filled) resting order: forget its ID, then unrest it.
+template <class Sink, class Ladder, class Range>
+void basic_orderbook<Sink, Ladder, Range>::retire(uint32_t node) {
+   ids_.erase(detail::id_of(pool_.cold(node)));
+   unrest(node);
+}
+
+template <class Sink, class Ladder, class Range>
+order_result basic_orderbook<Sink, Ladder, Range>::add(const order_t& order) {
+   order_side side = static_cast<order_side>(order.side);
+   const bool is_market = static_cast<order_kind>(order.kind) == order_kind::MKT;
+   if (is_market || static_cast<order_tif>(order.tif) != order_tif::GTC) {
+      if (side != order_side::BUY && side != order_side::SELL) return order_result::INVALID_SIDE;
+      if (!is_market && !range_.valid(order.price)) return order_result::INVALID_PRICE;
+      const uint32_t limit = is_market ? (side == order_side::BUY ? range_.max_price : 0) : order.price;
+      if (order.post_only && would_cross(side, limit)) return order_result::WOULD_CROSS;
+      return take(order, limit);
+   }
+
+   // Cheap checks first, so a rejected order never probes the index
+   if (side != order_side::BUY && side != order_side::SELL) return order_result::INVALID_SIDE;
+   if (!range_.valid(order.price)) return order_result::INVALID_PRICE;
+   if (order.post_only && would_cross(side, order.price)) return order_result::WOULD_CROSS;
+
+   const order_id_key id = detail::id_of(order);
+   if (ids_.find(id) != order_id_index::NONE) return order_result::DUPLICATE_ID;
+
+   const size_t remaining = match(order, order.price);
+   if (reporting()) flush_pending();
+   if (remaining == 0) return order_result::SUCCESS;
+
+   ids_.insert(id, rest(order, remaining));
+
+   if (reporting()) {
+      report(log_event_kind::PRICE_LEVEL_UPDATE, order.timestamp, id,
+             order.price, remaining, side);
+   }
+   return order_result::SUCCESS;
+}
+
+// True if an order on `side` limited at `limit` would trade on arrival.
+template <class Sink, class Ladder, class Range>
+bool basic_orderbook<Sink, Ladder, Range>::would_cross(order_side side, uint32_t limit) const {
+   const auto& opposite = (side == order_side::BUY ? asks_ : bids_);
+   const uint32_t top = opposite.top();
+   return top != Ladder::NO_LEVEL && opposite.reachable(top, limit);
+}
+
+// Resting quantity an order on `side` could reach up to `limit`. The walk
+// uses level totals only and stops as soon as `want` is covered.
+template <class Sink, class Ladder, class Range>
+size_t basic_orderbook<Sink, Ladder, Range>::depth_within(order_side side, uint32_t limit, size_t want) const {
+   const auto& opposite = (side == order_side::BUY ? asks_ : bids_);
+   size_t total = 0;
+   for (uint32_t px = opposite.top();
+        px != Ladder::NO_LEVEL && opposite.reachable(px, limit) && total < want;
+        px = opposite.next_after(px)) {
+      total += opposite[px].total_qty;
+   }
+   return total;
+}
+
+// Immediate-only order (market, IOC or FOK): trade what is available now
+// up to `limit` and cancel the rest. These orders never rest, so they skip
+// the ID index and level storage entirely.
+template <class Sink, class Ladder, class Range>
+order_result basic_orderbook<Sink, Ladder, Range>::take(const order_t& order, uint32_t limit) {
+   const order_side side = static_cast<order_side>(order.side);
+   if (static_cast<order_tif>(order.tif) == order_tif::FOK &&
+       depth_within(side, limit, order.qty) < order.qty) {
+      return order_result::INSUFFICIENT_LIQUIDITY;
+   }
+
+   const size_t remaining = match(order, limit);
+   if (reporting()) {
+      flush_pending();
+      if (remaining > 0) {
+         report(log_event_kind::CANCEL, order.timestamp, detail::id_of(order),
+                order.price, remaining, side);
+      }
+   }
+   return remaining < order.qty ? order_result::SUCCESS : order_result::NO_MATCH;
+}
+
+template <class Sink, class Ladder, class Range>
+order_result basic_orderbook<Sink, Ladder, Range>::modify(const order_id_key& id, const order_t& new_order) {
+   const uint32_t node = ids_.find(id);
+   if (node == order_id_index::NONE) return order_result::ORDER_NOT_FOUND;
+   // Nothing left to rest: that is a cancel, and is reported as one
+   if (new_order.qty == 0) return cancel(id, new_order.timestamp);
+
+   order_side new_side = static_cast<order_side>(new_order.side);
+   if (new_side != order_side::BUY && new_side != order_side::SELL) return order_result::INVALID_SIDE;
+   if (!range_.valid(new_order.price)) return order_result::INVALID_PRICE;
+   // A rejected post-only reprice leaves the original order untouched
+   if (new_order.post_only && would_cross(new_side, new_order.price)) return order_result::WOULD_CROSS;
+
+   // Same price and side with a smaller size: shrink in place. The order
+   // cannot cross and keeps its place in the queue.
+   order_node& stored = pool_[node];
+   const size_t old_qty = stored.qty;
+   const order_side old_side = stored.side;
+   const uint32_t old_price = stored.price;
+   if (old_side == new_side && old_price == new_order.price &&
+       new_order.qty > 0 && new_order.qty <= old_qty) {
+      auto& ladder = (new_side == order_side::BUY ? bids_ : asks_);
+      ladder[old_price].total_qty -= old_qty - new_order.qty;
+      stored.qty = new_order.qty;
+
+      if (reporting()) {
+         report(log_event_kind::MODIFY, new_order.timestamp,
+                id, new_order.price, new_order.qty, new_side,
+                id, old_price, old_qty, new_side);
+      }
+      return order_result::SUCCESS;
+   }
+
+   // The repriced order keeps the resting order's stored ID, in its trades
+   // and once it rests again
+   order_t repriced = new_order;
+   std::memcpy(repriced.order_id, pool_.cold(node).order_id, ORDER_ID_LEN);
+
+   // The node is recycled by unrest(); its fields were copied out above
+   unrest(node);
+
+   if (reporting()) {
+      report(log_event_kind::MODIFY, new_order.timestamp,
+             id, new_order.price, new_order.qty, new_side,
+             id, old_price, old_qty, old_side);
+   }
+
+   // The repriced order is aggressive again: cross first, rest the rest
+   const size_t remaining = match(repriced, repriced.price);
+   if (reporting()) flush_pending();
+   if (remaining == 0) {
+      ids_.erase(id);
+      return order_result::SUCCESS;
+   }
+
+   ids_.update(id, rest(repriced, remaining));
+   return order_result::SUCCESS;
+}
+
+template <class Sink, class Ladder, class Range>
+order_result basic_orderbook<Sink, Ladder, Range>::cancel(const order_id_key& id, uint64_t timestamp) {
+   const uint32_t node = ids_.find(id);
+   if (node == order_id_index::NONE) return order_result::ORDER_NOT_FOUND;
+
+   const order_node stored = pool_[node];
+   ids_.erase(id);
+   unrest(node);
+
+   if (reporting()) {
+      report(log_event_kind::CANCEL, timestamp, id,
+             stored.price, stored.qty, stored.side);
+   }
+   return order_result::SUCCESS;
+}
+
+template <class Sink, class Ladder, class Range>
+void basic_orderbook<Sink, Ladder, Range>::execute() {
+   uint64_t match_ts = 0;
+   while (true) {
+      auto bid_px = bids_.best();
+      auto ask_px = asks_.best();
+      if (!bid_px || !ask_px || *bid_px < *ask_px) break;
+      if (match_ts == 0) match_ts = detail::book_time_ns();
+
+      // Level heads are the oldest orders at each price
+      price_level& bid_level = bids_[*bid_px];
+      price_level& ask_level = asks_[*ask_px];
+      const uint32_t b_h = bid_level.head;
+      const uint32_t a_h = ask_level.head;
+
+      order_node& buy = pool_[b_h];
+      order_node& sell = pool_[a_h];
+      size_t m = std::min(buy.qty, sell.qty);
+      buy.qty -= m;
+      sell.qty -= m;
+      bid_level.total_qty -= m;
+      ask_level.total_qty -= m;
+
+      if (reporting()) {
+         report(log_event_kind::TRADE_REPORT, match_ts,
+                detail::id_of(pool_.cold(b_h)), *bid_px, m, order_side::BUY,
+                detail::id_of(pool_.cold(a_h)), *ask_px, m, order_side::SELL);
+      }
+
+      if (buy.qty == 0) retire(b_h);
+      if (sell.qty == 0) retire(a_h);
+   }
+}
+
+template <class Sink, class Ladder, class Range>
+order_result basic_orderbook<Sink, Ladder, Range>::apply(const order_t& order) {
+   switch (static_cast<order_status>(order.status)) {
+      case order_status::NEW:
+         return add(order);
+      case order_status::CANCELLED:
+         return cancel(detail::id_of(order), order.timestamp);
+      case order_status::PARTIALLY_FILLED:
+      case order_status::FILLED:
+         return modify(detail::id_of(order), order);
+      default:
+         return order_result::INVALID_STATUS;
+   }
+}
+
+template <class Sink, class Ladder, class Range>
+void basic_orderbook<Sink, Ladder, Range>::apply_batch(std::span<const order_t> orders,
+                                                       std::span<order_result> results) {
+   // Step s starts stage 1 for order s, stage 2 for order s - (AHEAD_IDS -
+   // AHEAD_NODES), stage 3 for order s - (AHEAD_IDS - AHEAD_LINKS), and
+   // applies order s - AHEAD_IDS. Stage 2 leaves each order's node in
+   // `nodes`, indexed by order modulo AHEAD_IDS, for stage 3.
+   const size_t n = orders.size();
+   uint32_t nodes[PREFETCH_AHEAD_IDS];
+   deferring_ = reporting();
+   for (size_t s = 0; s < n + PREFETCH_AHEAD_IDS; ++s) {
+      if (s < n) prefetch_ids(orders[s]);
+      if (const size_t i = s - (PREFETCH_AHEAD_IDS - PREFETCH_AHEAD_NODES);
+          s >= PREFETCH_AHEAD_IDS - PREFETCH_AHEAD_NODES && i < n) {
+         nodes[i % PREFETCH_AHEAD_IDS] = prefetch_resting(orders[i]);
+      }
+      if (const size_t i = s - (PREFETCH_AHEAD_IDS - PREFETCH_AHEAD_LINKS);
+          s >= PREFETCH_AHEAD_IDS - PREFETCH_AHEAD_LINKS && i < n) {
+         prefetch_links(nodes[i % PREFETCH_AHEAD_IDS]);
+      }
+      if (s >= PREFETCH_AHEAD_IDS) {
+         const order_result res = apply(orders[s - PREFETCH_AHEAD_IDS]);
+         if (!results.empty()) results[s - PREFETCH_AHEAD_IDS] = res;
+      }
+   }
+   if (deferring_) {
+      deferring_ = false;
+      flush_pending();
+   }
+}
+
+// Prefetch stages for apply_batch(). Each stage reads only lines the
+// previous stage requested a few orders earlier. Earlier orders in the
+// batch may change what a later stage reads (a node is freed, an ID is
+// erased); the loads are only hints, so stale data just prefetches the
+// wrong line and never affects results.
+
+// Stage 1: what the order itself names - its ID index slot and the level
+// it rests in.
+template <class Sink, class Ladder, class Range>
+void basic_orderbook<Sink, Ladder, Range>::prefetch_ids(const order_t& o) {
+   ids_.prefetch(detail::id_of(o));
+   if (static_cast<order_status>(o.status) != order_status::CANCELLED) {
+      (static_cast<order_side>(o.side) == order_side::BUY ? bids_ : asks_).prefetch(o.price);
+   }
+}
+
+// Stage 2: the resting node of an order being cancelled or modified,
+// found through the index slot stage 1 loaded. Returns the node, or
+// order_id_index::NONE for a new or unknown order.
+template <class Sink, class Ladder, class Range>
+uint32_t basic_orderbook<Sink, Ladder, Range>::prefetch_resting(const order_t& o) {
+   if (static_cast<order_status>(o.status) == order_status::NEW) return order_id_index::NONE;
+   const uint32_t node = ids_.find(detail::id_of(o));
+   pool_.prefetch(node);
+   return node;
+}
+
+// Stage 3: that node's level and the queue neighbours that unlinking it
+// rewrites.
+template <class Sink, class Ladder, class Range>
+void basic_orderbook<Sink, Ladder, Range>::prefetch_links(uint32_t node) {
+   if (node == order_id_index::NONE) return;
+   const order_node& n = pool_[node];
+   (n.side == order_side::BUY ? bids_ : asks_).prefetch(n.price);
+   pool_.prefetch(n.prev);
+   pool_.prefetch(n.next);
+}
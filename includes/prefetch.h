@@ -0,0 +1,14 @@
+#pragma once
+
+/**
+ * Hint that the cache line holding `p` will be written soon. A no-op on
+ * compilers without a prefetch builtin; never faults, so `p` may point at
+ * memory that is about to change or be reused.
+ */
+inline void prefetch_for_write(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+   __builtin_prefetch(p, 1, 3);
+#else
+   (void)p;
+#endif
+}
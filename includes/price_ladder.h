@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "occupancy_bitmap.h"
+#include "order_pool.h"
+#include "prefetch.h"
+#include "types.h"
+
+static constexpr uint32_t MAX_PRICE = 20000;
+
+/**
+ * Per-symbol price band: `width` levels starting at `base`, `tick` apart.
+ * The dense ladder covers exactly the band; prices outside it are still
+ * valid and rest in a sparse overflow map. Every price must sit on the
+ * tick grid (base + k * tick, below the band as well as above it).
+ *
+ * Also a runtime price range policy for basic_orderbook (see
+ * static_price_range for the interface). The default band is the old
+ * fixed 0..MAX_PRICE range at one-cent ticks.
+ */
+struct price_band {
+   uint32_t base = 0;
+   uint32_t tick = 1;
+   uint32_t width = MAX_PRICE + 1;
+
+   // UINT32_MAX is the ladders' NO_LEVEL, so it can never be a price
+   static constexpr uint32_t max_price = UINT32_MAX - 1;
+
+   bool valid(uint32_t price) const {
+      if (price > max_price) return false;
+      const uint32_t off = price >= base ? price - base : base - price;
+      return tick <= 1 || off % tick == 0;
+   }
+
+   const price_band& band() const { return *this; }
+
+   bool contains(uint32_t price) const {
+      return price >= base && index(price) < width;
+   }
+
+   // Level index of an on-tick price at or above base
+   uint32_t index(uint32_t price) const {
+      return tick == 1 ? price - base : (price - base) / tick;
+   }
+
+   uint32_t price_at(uint32_t index) const { return base + index * tick; }
+};
+
+/**
+ * Compile-time price range policy for basic_orderbook: prices 0..Max are
+ * valid, and a market buy is limited at Max. The ladder is sized from
+ * band(). Prices above Max are rejected, so nothing overflows the band.
+ */
+template <uint32_t Max = MAX_PRICE>
+struct static_price_range {
+   static constexpr uint32_t max_price = Max;
+   static constexpr bool valid(uint32_t price) { return price <= Max; }
+   static constexpr price_band band() { return price_band{0, 1, Max + 1}; }
+};
+
+/**
+ * Orders resting at one price, oldest first. The queue is an intrusive
+ * doubly-linked list threaded through order_pool nodes, so append and
+ * unlink-by-handle are O(1) and the head is always the oldest order.
+ */
+struct price_level {
+   uint32_t head = order_pool::NIL;
+   uint32_t tail = order_pool::NIL;
+   size_t total_qty = 0;
+
+   bool empty() const { return head == order_pool::NIL; }
+
+   void push_back(order_pool& pool, uint32_t h) {
+      order_node& node = pool[h];
+      node.prev = tail;
+      node.next = order_pool::NIL;
+      if (tail != order_pool::NIL) pool[tail].next = h;
+      else                         head = h;
+      tail = h;
+      total_qty += node.qty;
+   }
+
+   void unlink(order_pool& pool, uint32_t h) {
+      order_node& node = pool[h];
+      if (node.prev != order_pool::NIL) pool[node.prev].next = node.next;
+      else                              head = node.next;
+      if (node.next != order_pool::NIL) pool[node.next].prev = node.prev;
+      else                              tail = node.prev;
+      total_qty -= node.qty;
+   }
+};
+
+/**
+ * One side of the book stored as a flat array of price levels, one per
+ * tick of the symbol's price_band. Levels are never allocated or freed
+ * while trading inside the band; a level is "occupied" while it holds at
+ * least one order.
+ *
+ * Occupancy is mirrored in a hierarchical bitmap so the best level and the
+ * next level behind any price are found with a few lzcnt/tzcnt, however
+ * sparse the ladder is. The best price is additionally cached so
+ * best_bid()/best_ask() are a single load.
+ *
+ * Prices outside the band live in a std::map of occupied levels, created
+ * on first insert and erased when they empty. Searches take the better of
+ * the band and the overflow candidates, and skip the overflow entirely
+ * while it is empty, which is the normal case for a well-chosen band.
+ */
+class price_ladder final {
+public:
+   static constexpr uint32_t NO_LEVEL = occupancy_bitmap::NONE;
+
+   explicit price_ladder(order_side side, const price_band& band = price_band{})
+     : band_(clamp(band)), levels_(band_.width), occupied_(band_.width), side_(side) {}
+
+   price_level& operator[](uint32_t price) {
+      if (band_.contains(price)) return levels_[band_.index(price)];
+      return overflow_[price];
+   }
+
+   const price_level& operator[](uint32_t price) const {
+      if (band_.contains(price)) return levels_[band_.index(price)];
+      return overflow_.find(price)->second;
+   }
+
+   // Start loading the level for `price`; overflow levels are not prefetched
+   void prefetch(uint32_t price) const {
+      if (band_.contains(price)) prefetch_for_write(&levels_[band_.index(price)]);
+   }
+
+   bool empty() const { return best_ == NO_LEVEL; }
+
+   std::optional<uint32_t> best() const {
+      if (best_ == NO_LEVEL) return std::nullopt;
+      return best_;
+   }
+
+   // Best occupied price, or NO_LEVEL.
+   uint32_t top() const { return best_; }
+
+   // True if `price` is at or behind `limit` in priority order, i.e. an
+   // opposite order limited at `limit` could trade here.
+   bool reachable(uint32_t price, uint32_t limit) const {
+      return side_ == order_side::BUY ? price >= limit : price <= limit;
+   }
+
+   // Next occupied price behind `price` in priority order (lower for bids,
+   // higher for asks), or NO_LEVEL.
+   uint32_t next_after(uint32_t price) const {
+      const uint32_t in_band = next_in_band(price);
+      if (overflow_.empty()) return in_band;
+      return better_of(in_band, next_in_overflow(price));
+   }
+
+   // Must be called after the first order is inserted into an empty level.
+   void mark_occupied(uint32_t price) {
+      if (band_.contains(price)) occupied_.set(band_.index(price));
+      if (best_ == NO_LEVEL || is_better(price, best_)) best_ = price;
+   }
+
+   // Must be called after the last order is removed from a level.
+   void mark_empty(uint32_t price) {
+      if (band_.contains(price)) occupied_.clear(band_.index(price));
+      else                       overflow_.erase(price);
+      if (price == best_) best_ = next_after(price);
+   }
+
+   const price_band& band() const { return band_; }
+
+   // Occupied levels outside the band
+   size_t overflow_levels() const { return overflow_.size(); }
+
+private:
+   // Fit the band to the bitmap and keep its top price representable
+   static price_band clamp(price_band band) {
+      if (band.tick == 0) band.tick = 1;
+      const uint64_t span =
+         (price_band::max_price - std::min(band.base, price_band::max_price)) / band.tick + 1;
+      const uint64_t width = std::min<uint64_t>({band.width, span, occupancy_bitmap::MAX_SLOTS});
+      band.width = static_cast<uint32_t>(std::max<uint64_t>(width, 1));
+      return band;
+   }
+
+   bool is_better(uint32_t a, uint32_t b) const {
+      return side_ == order_side::BUY ? a > b : a < b;
+   }
+
+   uint32_t better_of(uint32_t a, uint32_t b) const {
+      if (a == NO_LEVEL) return b;
+      if (b == NO_LEVEL) return a;
+      return is_better(a, b) ? a : b;
+   }
+
+   uint32_t to_price(uint32_t index) const {
+      return index == occupancy_bitmap::NONE ? NO_LEVEL : band_.price_at(index);
+   }
+
+   // Occupied band level strictly behind `price`, which may lie outside it
+   uint32_t next_in_band(uint32_t price) const {
+      if (side_ == order_side::BUY) {
+         if (price < band_.base) return NO_LEVEL;
+         if (!band_.contains(price)) return to_price(occupied_.highest());
+         return to_price(occupied_.next_below(band_.index(price)));
+      }
+      if (price < band_.base) return to_price(occupied_.lowest());
+      if (!band_.contains(price)) return NO_LEVEL;
+      return to_price(occupied_.next_above(band_.index(price)));
+   }
+
+   uint32_t next_in_overflow(uint32_t price) const {
+      if (side_ == order_side::BUY) {
+         auto it = overflow_.lower_bound(price);
+         return it == overflow_.begin() ? NO_LEVEL : std::prev(it)->first;
+      }
+      auto it = overflow_.upper_bound(price);
+      return it == overflow_.end() ? NO_LEVEL : it->first;
+   }
+
+   price_band band_;
+   std::vector<price_level> levels_;
+   occupancy_bitmap occupied_;
+   std::map<uint32_t, price_level> overflow_;
+   uint32_t best_ = NO_LEVEL;
+   order_side side_;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Message rate (or count over some window) observed for one symbol.
+ */
+struct symbol_load {
+   std::string symbol;
+   uint64_t rate;
+};
+
+/**
+ * One planned migration of a symbol's book between workers.
+ */
+struct shard_move {
+   std::string symbol;
+   uint32_t from;
+   uint32_t to;
+};
+
+/**
+ * Assignment of symbols to N worker threads. Symbols without an explicit
+ * assignment go to a worker chosen by hashing the symbol, so any symbol
+ * always has a worker.
+ *
+ * A map can be written by hand or saved from a previous session (one
+ * "SYMBOL WORKER" pair per line, '#' starts a comment), or computed from
+ * measured per-symbol rates. plan_moves() proposes the few migrations
+ * that best even out a live assignment.
+ */
+class shard_map final {
+public:
+   static constexpr uint32_t DEFAULT_WORKERS = 31;
+
+   shard_map() : shard_map(DEFAULT_WORKERS) {}
+   explicit shard_map(uint32_t workers);
+
+   uint32_t workers() const { return workers_; }
+
+   uint32_t worker_for(const std::string& symbol) const;
+   void assign(const std::string& symbol, uint32_t worker);
+   const std::unordered_map<std::string, uint32_t>& assignments() const { return assigned_; }
+
+   // Throws std::runtime_error if the file cannot be read or a line is
+   // malformed; workers out of range are reduced modulo `workers`.
+   static shard_map load(const std::string& path, uint32_t workers = DEFAULT_WORKERS);
+   void save(const std::string& path) const;
+
+   // Longest-processing-time greedy: heaviest symbol first, each onto the
+   // currently least loaded worker.
+   static shard_map balance(std::vector<symbol_load> loads, uint32_t workers = DEFAULT_WORKERS);
+
+   // Up to `max_moves` migrations that bring the busiest worker within
+   // `tolerance` of the mean load. Each move takes, from the busiest
+   // worker to the least busy one, the symbol whose rate comes closest to
+   // half their difference without exceeding it, so every move strictly
+   // reduces the imbalance and quiet symbols are preferred over hot ones
+   // that would overshoot.
+   std::vector<shard_move> plan_moves(const std::vector<symbol_load>& loads,
+                                      double tolerance = 0.1,
+                                      size_t max_moves = 4) const;
+
+private:
+   uint32_t workers_;
+   std::unordered_map<std::string, uint32_t> assigned_;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+/**
+ * Bounded single-producer single-consumer ring.
+ *
+ * Storage is allocated once, at construction, rounded up to a power of
+ * two; the ring holds at most `capacity` items. The producer owns tail_
+ * and the consumer head_, each on its own cache line, and each side keeps
+ * a private copy of the other's index so it only re-reads the shared one
+ * when the ring looks full (or empty). In steady state a message costs
+ * the slot's cache line moving from producer to consumer and nothing
+ * else.
+ *
+ * Exactly one thread may push and one thread may pop at a time.
+ */
+template <class T>
+class spsc_ring final {
+public:
+   explicit spsc_ring(size_t capacity) : capacity_(capacity ? capacity : 1) {
+      size_t cap = 2;
+      while (cap < capacity_) cap <<= 1;
+      mask_ = cap - 1;
+      slots_ = std::make_unique<T[]>(cap);
+   }
+
+   spsc_ring(const spsc_ring&) = delete;
+   spsc_ring& operator=(const spsc_ring&) = delete;
+
+   size_t capacity() const { return capacity_; }
+
+   // Producer. Returns false if the ring is full.
+   bool try_push(const T& item) {
+      const uint64_t tail = prod_.tail.load(std::memory_order_relaxed);
+      if (tail - prod_.head_cache >= capacity_) {
+         prod_.head_cache = cons_.head.load(std::memory_order_acquire);
+         if (tail - prod_.head_cache >= capacity_) return false;
+      }
+      slots_[tail & mask_] = item;
+      prod_.tail.store(tail + 1, std::memory_order_release);
+      return true;
+   }
+
+   // Consumer. Moves up to `max` items into `out`, returns how many.
+   size_t try_pop_bulk(T* out, size_t max) {
+      const uint64_t head = cons_.head.load(std::memory_order_relaxed);
+      if (cons_.tail_cache - head < max) {
+         cons_.tail_cache = prod_.tail.load(std::memory_order_acquire);
+      }
+      size_t n = static_cast<size_t>(cons_.tail_cache - head);
+      if (n > max) n = max;
+      for (size_t i = 0; i < n; ++i) out[i] = slots_[(head + i) & mask_];
+      if (n) cons_.head.store(head + n, std::memory_order_release);
+      return n;
+   }
+
+   // Any thread: items pushed / popped so far. A consumer that has popped
+   // up to pushed() as read earlier has seen everything pushed before.
+   uint64_t pushed() const { return prod_.tail.load(std::memory_order_acquire); }
+   uint64_t popped() const { return cons_.head.load(std::memory_order_acquire); }
+
+   bool empty() const { return popped() == pushed(); }
+
+   // Any thread: items in the ring, as of some recent moment
+   size_t size() const {
+      const uint64_t head = popped();   // first: head never passes tail
+      return static_cast<size_t>(pushed() - head);
+   }
+
+private:
+   static constexpr size_t LINE = 64;
+
+   struct alignas(LINE) producer_side {
+      std::atomic<uint64_t> tail{0};
+      uint64_t head_cache = 0;
+   };
+   struct alignas(LINE) consumer_side {
+      std::atomic<uint64_t> head{0};
+      uint64_t tail_cache = 0;
+   };
+
+   producer_side prod_;
+   consumer_side cons_;
+   size_t capacity_;
+   size_t mask_;
+   std::unique_ptr<T[]> slots_;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__linux__)
+   #include <pthread.h>
+   #include <sched.h>
+#endif
+
+/**
+ * Where the exchange's long-running threads run. A negative CPU (or a
+ * worker missing from the map) leaves that thread to the scheduler.
+ *
+ * Memory placement follows from pinning: Linux's default policy puts a
+ * page on the NUMA node of the thread that first touches it, so each
+ * worker builds its own queue and books after it has been pinned. Threads
+ * that call io_context::run() for the network server belong to the
+ * caller, which pins them with pin_current_thread().
+ */
+struct thread_placement_t {
+   // Worker label -> logical CPU: shard worker index in local_exchange
+   // ("0", "1", ...), symbol in exchange
+   std::unordered_map<std::string, int> worker_cpu;
+   int logger_cpu = -1;
+   int publisher_cpu = -1;
+
+   int cpu_for(const std::string& worker) const {
+      auto it = worker_cpu.find(worker);
+      return it == worker_cpu.end() ? -1 : it->second;
+   }
+};
+
+// Pin a thread to logical CPU `cpu`. Returns false if `cpu` is negative,
+// the platform has no thread affinity API (macOS), or the call fails.
+inline bool pin_thread(std::thread::native_handle_type handle, int cpu) {
+#if defined(__linux__)
+   if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   return pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+#else
+   (void)handle;
+   (void)cpu;
+   return false;
+#endif
+}
+
+inline bool pin_thread(std::thread& t, int cpu) { return pin_thread(t.native_handle(), cpu); }
+
+inline bool pin_current_thread(int cpu) {
+#if defined(__linux__)
+   return pin_thread(pthread_self(), cpu);
+#else
+   (void)cpu;
+   return false;
+#endif
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * Small dense per-thread index, for tables with one entry per thread
+ * (epoch slots, gateway lanes). A thread claims the lowest free index on
+ * first call and returns it when it exits, so a later thread may reuse
+ * it; by then the previous owner has stopped touching its entries.
+ */
+static constexpr size_t MAX_THREAD_SLOTS = 256;
+
+namespace thread_slot_detail {
+
+inline std::array<std::atomic<bool>, MAX_THREAD_SLOTS>& in_use() {
+   static std::array<std::atomic<bool>, MAX_THREAD_SLOTS> used{};
+   return used;
+}
+
+inline size_t take() {
+   auto& used = in_use();
+   for (size_t i = 0; i < MAX_THREAD_SLOTS; ++i) {
+      bool expected = false;
+      if (!used[i].load(std::memory_order_relaxed) &&
+          used[i].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+         return i;
+      }
+   }
+   throw std::runtime_error("more than MAX_THREAD_SLOTS threads hold a thread slot");
+}
+
+} // namespace thread_slot_detail
+
+inline size_t thread_slot() {
+   struct claim {
+      size_t index;
+      claim() : index(thread_slot_detail::take()) {}
+      ~claim() { thread_slot_detail::in_use()[index].store(false, std::memory_order_release); }
+   };
+   thread_local claim c;
+   return c.index;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.h"
+
+/**
+ * A ticker's TICKER_LEN (4) bytes read as one integer, so routing compares
+ * and hashes a register instead of a string. Shorter tickers are NUL
+ * padded, which leaves 0 free to mean "no ticker".
+ */
+using ticker_key_t = uint32_t;
+static_assert(TICKER_LEN == sizeof(ticker_key_t), "ticker must fit a ticker_key_t");
+
+inline ticker_key_t ticker_key(const char (&ticker)[TICKER_LEN]) {
+   ticker_key_t key;
+   std::memcpy(&key, ticker, TICKER_LEN);
+   return key;
+}
+
+// Symbol as written in configs ("IBM"); characters past TICKER_LEN are
+// ignored
+inline ticker_key_t ticker_key(std::string_view symbol) {
+   char padded[TICKER_LEN] = {};
+   std::memcpy(padded, symbol.data(), std::min(symbol.size(), TICKER_LEN));
+   return ticker_key(padded);
+}
+
+// The symbol without its padding
+inline std::string ticker_name(ticker_key_t key) {
+   char padded[TICKER_LEN];
+   std::memcpy(padded, &key, TICKER_LEN);
+   return std::string(padded, strnlen(padded, TICKER_LEN));
+}
+
+/**
+ * Flat open-addressing (linear probing) map from ticker_key_t to a small
+ * value. Filled as symbols are registered; find() neither allocates nor
+ * hashes more than one multiply. Capacity doubles when the table passes
+ * half full, so probe chains stay short. Key 0 marks an empty slot.
+ */
+template <class Value>
+class ticker_table final {
+public:
+   static constexpr size_t MIN_CAPACITY = 64;
+
+   explicit ticker_table(size_t expected = 0) {
+      size_t cap = MIN_CAPACITY;
+      while (cap / 2 < expected) cap <<= 1;
+      slots_.assign(cap, slot{});
+   }
+
+   size_t size() const { return size_; }
+
+   // Value for `key`, or nullptr
+   const Value* find(ticker_key_t key) const {
+      const slot& s = probe(slots_, key);
+      return s.key == key && key != 0 ? &s.value : nullptr;
+   }
+
+   Value* find(ticker_key_t key) {
+      return const_cast<Value*>(static_cast<const ticker_table&>(*this).find(key));
+   }
+
+   // Store key -> value, replacing any existing value. `key` must not be 0.
+   void insert(ticker_key_t key, const Value& value) {
+      if ((size_ + 1) * 2 > slots_.size()) grow();
+      slot& s = probe(slots_, key);
+      if (s.key == 0) ++size_;
+      s = slot{key, value};
+   }
+
+private:
+   struct slot {
+      ticker_key_t key = 0;
+      Value value{};
+   };
+
+   // Fibonacci hashing: ASCII tickers differ in few bits, the multiply
+   // spreads them over the top bits used as the index
+   static size_t index(ticker_key_t key, size_t mask) {
+      return (static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ull >> 32) & mask;
+   }
+
+   // The slot holding `key`, or the empty slot where it would go
+   template <class Slots>
+   static auto& probe(Slots& slots, ticker_key_t key) {
+      const size_t mask = slots.size() - 1;
+      for (size_t i = index(key, mask);; i = (i + 1) & mask) {
+         if (slots[i].key == key || slots[i].key == 0) return slots[i];
+      }
+   }
+
+   void grow() {
+      std::vector<slot> old(slots_.size() * 2, slot{});
+      old.swap(slots_);
+      for (const slot& s : old) {
+         if (s.key != 0) probe(slots_, s.key) = s;
+      }
+   }
+
+   std::vector<slot> slots_;
+   size_t size_ = 0;
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/**
+ * Tracepoints for the exchange's threads.
+ *
+ * TRACE(POINT, ticker, a, b) records a fixed 32-byte binary record into
+ * the calling thread's own ring: a timestamp, the point, a ticker key and
+ * two integers whose meaning depends on the point (listed with each point
+ * below; the networked Exchange has no workers, lanes or book indices and
+ * leaves those fields 0). Nothing is formatted and nothing is shared with
+ * other threads on the way in. Each ring keeps the newest
+ * TRACE_RING_RECORDS records and overwrites older ones (a flight
+ * recorder).
+ *
+ * Tracepoints are compiled out unless HFT_TRACE is defined to 1 (CMake:
+ * -DHFT_TRACE=ON); disabled, TRACE() expands to nothing and its arguments
+ * are not evaluated.
+ *
+ * trace_collect() / trace_dump() read every thread's ring, including
+ * threads that have exited. Call them once the traced threads are stopped:
+ * records being written while they are read may come out torn.
+ */
+#ifndef HFT_TRACE
+   #define HFT_TRACE 0
+#endif
+
+enum class trace_point : uint16_t {
+   // lifecycle
+   EXCHANGE_START,
+   EXCHANGE_STOP,
+   SYMBOL_ADDED,     // ticker; a: worker index
+   WORKER_START,     // a: worker index
+   WORKER_EXIT,      // a: worker index
+   PIN_FAILED,       // a: cpu
+   // ingress
+   MSG_RECEIVED,     // a: length
+   PARSE_FAILED,     // a: length
+   ORDER_PARSED,     // ticker; a: price, b: qty
+   NO_ROUTE,         // ticker
+   ENQUEUED,         // ticker; a: book, b: worker
+   SHED,             // ticker; a: book, b: worker
+   HELD,             // ticker; a: book
+   NEW_LANE,         // a: thread slot, b: worker
+   // workers
+   BATCH,            // a: orders, b: worker
+   ORDER_APPLIED,    // ticker; a: order_status, b: order_result
+   BOOK_BUILT,       // ticker; a: book
+   BOOK_RELEASED,    // a: book
+   BOOK_ADOPTED,     // a: book, b: held orders applied
+   MIGRATING,        // ticker; a: from, b: to
+   COUNT
+};
+
+inline const char* trace_point_name(trace_point p) {
+   static constexpr const char* NAMES[] = {
+      "exchange_start", "exchange_stop", "symbol_added", "worker_start", "worker_exit",
+      "pin_failed", "msg_received", "parse_failed", "order_parsed",
+      "no_route", "enqueued", "shed", "held", "new_lane", "batch", "order_applied",
+      "book_built", "book_released", "book_adopted", "migrating",
+   };
+   static_assert(std::size(NAMES) == static_cast<size_t>(trace_point::COUNT));
+   const auto i = static_cast<size_t>(p);
+   return i < std::size(NAMES) ? NAMES[i] : "unknown";
+}
+
+struct trace_record {
+   uint64_t ns;        // steady_clock
+   uint16_t point;     // trace_point
+   uint16_t thread;    // ring index, in order of first trace
+   uint32_t ticker;    // ticker_key_t, 0 if none
+   uint64_t a;
+   uint64_t b;
+};
+static_assert(sizeof(trace_record) == 32);
+
+static constexpr size_t TRACE_RING_RECORDS = size_t{1} << 14;
+
+namespace trace_detail {
+
+struct ring {
+   std::unique_ptr<trace_record[]> records{new trace_record[TRACE_RING_RECORDS]};
+   std::atomic<uint64_t> written{0};   // owner writes, dump reads
+   uint16_t index = 0;
+};
+
+struct registry {
+   std::mutex mutex;
+   std::vector<std::shared_ptr<ring>> rings;   // outlive their threads
+};
+
+inline registry& rings() {
+   static registry r;
+   return r;
+}
+
+// This thread's ring, registered on first use
+inline ring& local() {
+   thread_local std::shared_ptr<ring> mine = [] {
+      auto r = std::make_shared<ring>();
+      registry& reg = rings();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      r->index = static_cast<uint16_t>(reg.rings.size());
+      reg.rings.push_back(r);
+      return r;
+   }();
+   return *mine;
+}
+
+} // namespace trace_detail
+
+inline void trace_emit(trace_point point, uint32_t ticker = 0, uint64_t a = 0, uint64_t b = 0) {
+   trace_detail::ring& r = trace_detail::local();
+   const uint64_t n = r.written.load(std::memory_order_relaxed);
+   const uint64_t ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count());
+   r.records[n & (TRACE_RING_RECORDS - 1)] =
+      trace_record{ns, static_cast<uint16_t>(point), r.index, ticker, a, b};
+   r.written.store(n + 1, std::memory_order_release);
+}
+
+// Every retained record from every thread, oldest first
+inline std::vector<trace_record> trace_collect() {
+   std::vector<trace_record> out;
+   trace_detail::registry& reg = trace_detail::rings();
+   std::lock_guard<std::mutex> lock(reg.mutex);
+   for (const auto& r : reg.rings) {
+      const uint64_t n = r->written.load(std::memory_order_acquire);
+      const uint64_t first = n > TRACE_RING_RECORDS ? n - TRACE_RING_RECORDS : 0;
+      for (uint64_t i = first; i < n; ++i) out.push_back(r->records[i & (TRACE_RING_RECORDS - 1)]);
+   }
+   std::stable_sort(out.begin(), out.end(),
+                    [](const trace_record& x, const trace_record& y) { return x.ns < y.ns; });
+   return out;
+}
+
+// One line per record: "ns thread point ticker a b"
+inline void trace_dump(std::ostream& os) {
+   for (const trace_record& r : trace_collect()) {
+      char ticker[5] = {};
+      for (int i = 0; i < 4; ++i) ticker[i] = static_cast<char>((r.ticker >> (8 * i)) & 0xff);
+      os << r.ns << ' ' << r.thread << ' ' << trace_point_name(static_cast<trace_point>(r.point))
+         << ' ' << (ticker[0] ? ticker : "-") << ' ' << r.a << ' ' << r.b << '\n';
+   }
+}
+
+#if HFT_TRACE
+   #define TRACE(point, ...) trace_emit(trace_point::point __VA_OPT__(,) __VA_ARGS__)
+#else
+   #define TRACE(point, ...) do {} while (0)
+#endif
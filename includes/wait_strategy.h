@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+   #include <immintrin.h>
+#endif
+
+/**
+ * What a book thread does while its queue is empty.
+ *   SPIN       - poll continuously with a pause between polls. Lowest
+ *                wakeup latency; burns a core even when idle.
+ *   SPIN_YIELD - spin briefly, then yield the CPU between polls. Leaves
+ *                the core to other threads but still never sleeps.
+ *   SPIN_PARK  - spin, yield a few times, then sleep on a futex until a
+ *                producer enqueues. Idle threads cost nothing; the first
+ *                order after a quiet period pays one wakeup (microseconds).
+ */
+enum class wait_policy : uint8_t { SPIN=0, SPIN_YIELD=1, SPIN_PARK=2 };
+
+// One polling pause: `pause` on x86, a plain yield hint elsewhere
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+   _mm_pause();
+#elif defined(__aarch64__)
+   asm volatile("yield");
+#endif
+}
+
+/**
+ * Idle handling for one consumer thread and any number of producers.
+ *
+ * The consumer calls idle() each time it polls an empty queue and reset()
+ * once it finds work; idle() escalates from spinning to yielding to
+ * parking according to the policy. Producers call notify() after every
+ * enqueue, which only touches shared state while the consumer is parked.
+ * wake() releases a parked consumer unconditionally (shutdown).
+ *
+ * Parking uses C++20 atomic wait/notify (a futex on Linux). The consumer
+ * announces itself in parked_, then re-checks for work before sleeping on
+ * seq_; a producer enqueues, then checks parked_. A full fence on each
+ * side guarantees that either the consumer sees the new item or the
+ * producer sees parked_ and bumps seq_, so no wakeup is lost.
+ */
+class queue_waiter final {
+public:
+   static constexpr uint32_t SPIN_ROUNDS = 4096;
+   static constexpr uint32_t YIELD_ROUNDS = 64;
+
+   queue_waiter(wait_policy policy = wait_policy::SPIN_PARK) : policy_(policy) {}
+
+   // non-copyable, non-movable: producers hold references
+   queue_waiter(const queue_waiter&) = delete;
+   queue_waiter& operator=(const queue_waiter&) = delete;
+
+   wait_policy policy() const { return policy_; }
+
+   // Consumer: wait a little after an empty poll. `ready` is called before
+   // parking and must return true once there is work or the thread should
+   // stop.
+   template <class Ready>
+   void idle(Ready&& ready) {
+      const uint32_t round = rounds_ < UINT32_MAX ? rounds_++ : rounds_;
+      if (policy_ == wait_policy::SPIN || round < SPIN_ROUNDS) {
+         cpu_relax();
+      } else if (policy_ == wait_policy::SPIN_YIELD || round < SPIN_ROUNDS + YIELD_ROUNDS) {
+         std::this_thread::yield();
+      } else {
+         park(ready);
+      }
+   }
+
+   // Consumer: found work, so the next idle period starts with spinning
+   void reset() { rounds_ = 0; }
+
+   // Producer: call after enqueueing
+   void notify() {
+      if (policy_ != wait_policy::SPIN_PARK) return;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (parked_.load(std::memory_order_relaxed)) wake();
+   }
+
+   // Release the consumer whatever it is doing
+   void wake() {
+      seq_.fetch_add(1, std::memory_order_release);
+      seq_.notify_one();
+   }
+
+private:
+   template <class Ready>
+   void park(Ready& ready) {
+      parked_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const uint32_t seen = seq_.load(std::memory_order_acquire);
+      if (!ready()) seq_.wait(seen, std::memory_order_acquire);
+      parked_.store(false, std::memory_order_relaxed);
+   }
+
+   // Producers read these in notify()
+   const wait_policy policy_;
+   std::atomic<bool> parked_{false};
+   std::atomic<uint32_t> seq_{0};
+
+   // Consumer only, written on every idle round: its own line, so those
+   // writes do not pull the line above away from producers
+   alignas(64) uint32_t rounds_ = 0;
+};
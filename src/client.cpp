@@ -144,16 +144,20 @@ int main() {
 
     OrderParser parser;
     logger log("client.log");
-    Exchange exch(&log, &parser);
+    // A replay wants every event applied, so wait out full shards
+    exchange_options_t options;
+    options.overload = overload_policy::BLOCK;
+    Exchange exch(&log, &parser, {}, options);
     exch.start();
 
     std::vector<uint64_t> proc_times_ns;
     proc_times_ns.reserve(all_events.size());
     auto wall_start = steady_clock::now();
 
+    size_t refused = 0;
     for (auto &ev : all_events) {
         auto t0 = steady_clock::now();
-        exch.on_msg_received(ev.buf.data(), ev.buf.size());
+        if (exch.on_msg_received(ev.buf.data(), ev.buf.size()) != order_result::SUCCESS) ++refused;
         uint64_t dt = duration_cast<nanoseconds>(steady_clock::now() - t0).count();
         proc_times_ns.push_back(dt);
     }
@@ -175,6 +179,7 @@ int main() {
 
         std::cout << "\n=== PERFORMANCE STATISTICS ===\n"
                   << "Events processed:     " << n        << "\n"
+                  << "Refused at gateway:   " << refused  << "\n"
                   << "Wall-clock time:      " << wall_sec << " s\n"
                   << "Avg per-event:        " << avg_us   << " μs\n"
                   << "Min / Max:            " << min_us   << " μs / " << max_us << " μs\n"
@@ -1,156 +1,131 @@
 // exchange.cpp
 #include "exchange.h"
+#include "trace.h"
 #include <chrono>
 #include <thread>
 #include <cstring>
-#include <iostream>
 #include <utility>
-#include <unordered_map>
 #include <string>
-#include <vector>
-#include <algorithm>
-#include <cctype>
+#include <string_view>
 
 using namespace std::chrono_literals;
 
-// ----------------------------------------------------------------
-// 1) Define the buckets exactly as on your chart
-//    (Not strictly required at runtime, but kept for reference.)
-// ----------------------------------------------------------------
-static const std::vector<std::string> BUCKETS = {
-    "A","B","C","D",
-    "EA-E","EF-Z",
-    "F","G","H",
-    "IA-E","IF-Z",
-    "J","K","L","M","N","O",
-    "PA-E","PF-Z",
-    "Q","R",
-    "SA-E","SF-N","SO-Z",
-    "T","U","V","W","X","Y","Z"
-};
-
-// ----------------------------------------------------------------
-// 2) Helper: map a ticker → bucket label
-// ----------------------------------------------------------------
-static std::string get_bucket(const std::string& sym) {
-    if (sym.empty()) return "";
-    char c0 = std::toupper(sym[0]);
-    char c1 = sym.size()>1 ? std::toupper(sym[1]) : '\0';
-
-    switch (c0) {
-      case 'E': return (c1>='A' && c1<='E') ? "EA-E" : "EF-Z";
-      case 'I': return (c1>='A' && c1<='E') ? "IA-E" : "IF-Z";
-      case 'P': return (c1>='A' && c1<='E') ? "PA-E" : "PF-Z";
-      case 'S':
-        if      (c1>='A' && c1<='E') return "SA-E";
-        else if (c1>='F' && c1<='N') return "SF-N";
-        else                          return "SO-Z";
-      default:
-        if (c0>='A' && c0<='Z')
-            return std::string(1, c0);
-        return "";
-    }
-}
-
-// ----------------------------------------------------------------
-// 3) Per‐bucket storage of per‐ticker orderbooks
-// ----------------------------------------------------------------
-static std::unordered_map<
-    std::string,                                 // bucket label
-    std::unordered_map<std::string, orderbook>   // symbol → orderbook
-> bucket_books;
-
 Exchange::Exchange(logger* logger_ptr,
                    OrderParser* parser_ptr,
-                   MarketDataPublisher* publisher_ptr)
+                   MarketDataPublisher* publisher_ptr,
+                   const orderbook_config_t& book_config,
+                   const thread_placement_t& placement,
+                   size_t queue_capacity,
+                   overload_policy overload)
   : logger_(logger_ptr)
   , parser_(parser_ptr)
   , publisher_(publisher_ptr)
+  , book_config_(book_config)
+  , placement_(placement)
+  , queue_capacity_(queue_capacity)
+  , overload_(overload)
   , running_(false)
   , network_(nullptr)
 {
-    std::cout << "[DEBUG] Exchange constructed\n";
+    if (logger_ && placement_.logger_cpu >= 0) logger_->pin_to_cpu(placement_.logger_cpu);
+    if (publisher_) publisher_->set_cpu(placement_.publisher_cpu);
 }
 
 Exchange::~Exchange() {
     stop();
     delete network_;
-    std::cout << "[DEBUG] Exchange destructed\n";
 }
 
 void Exchange::start() {
     running_.store(true);
-    std::cout << "[DEBUG] Exchange::start() – running_=true\n";
+    TRACE(EXCHANGE_START);
     publisher_->start();
     if (network_) network_->start();
 }
 
 void Exchange::stop() {
     if (!running_.exchange(false)) return;
-    std::cout << "[DEBUG] Exchange::stop() – running_=false\n";
+    TRACE(EXCHANGE_STOP);
     if (network_) network_->stop();
     publisher_->stop();
-    for (auto & [sym, bt] : bookThreads_)
-      if (bt.thread.joinable()) bt.thread.join();
+    for (auto& bt : bookThreadStore_) {
+      bt->waiter.wake();
+      if (bt->thread.joinable()) bt->thread.join();
+    }
 }
 
-void Exchange::add_symbol(const char* symbol) {
-    std::string sym(symbol, TICKER_LEN);
-    std::cout << "[DEBUG] add_symbol: " << sym << "\n";
-
-    auto [it, inserted] = bookThreads_.emplace(
-      std::piecewise_construct,
-      std::forward_as_tuple(sym),
-      std::forward_as_tuple(
-        orderbook(logger_),
-        moodycamel::ConcurrentQueue<order_t>(),
-        std::thread()
-      )
-    );
-    if (!inserted) {
-      std::cout << "[DEBUG] symbol already exists: " << sym << "\n";
-      return;
+bool Exchange::add_symbol(const char* symbol, const price_band& band, wait_policy wait) {
+    const ticker_key_t key = ticker_key(std::string_view(symbol, strnlen(symbol, TICKER_LEN)));
+    if (key == 0 || bookThreads_.find(key)) {
+      return false;
     }
 
-    auto &bt = it->second;
-    bt.thread = std::thread(&Exchange::book_loop, this, &bt);
-    std::cout << "[DEBUG] spawned book thread for " << sym << "\n";
+    auto& bt = *bookThreadStore_.emplace_back(std::make_unique<BookThread>(wait));
+    bookThreads_.insert(key, &bt);
+    bt.thread = std::thread(&Exchange::book_loop, this, &bt, band,
+                            placement_.cpu_for(ticker_name(key)));
+    // Orders may be enqueued as soon as we return
+    bt.ready.wait(false, std::memory_order_acquire);
+    TRACE(SYMBOL_ADDED, key);
+    return true;
 }
 
-void Exchange::on_msg_received(const uint8_t* data, size_t len) {
-    std::cout << "[DEBUG] on_msg_received(len=" << len << ")\n";
+order_result Exchange::on_msg_received(const uint8_t* data, size_t len) {
+    TRACE(MSG_RECEIVED, 0, len);
     ParsedOrder parsed;
     if (!parser_->parse_message(data, len, parsed)) {
-      std::cout << "[DEBUG] parse_message failed\n";
-      return;
+      TRACE(PARSE_FAILED, 0, len);
+      return order_result::MALFORMED;
     }
     order_t order = parser_->convert_to_order(parsed);
-    std::cout << "[DEBUG] parsed order id="
-              << std::string(order.order_id, ORDER_ID_LEN)
-              << " ticker=" << std::string(order.ticker, TICKER_LEN)
-              << " price=" << order.price
-              << " qty=" << order.qty << "\n";
-    enqueue_order(order);
+    TRACE(ORDER_PARSED, ticker_key(order.ticker), order.price, order.qty);
+    return enqueue_order(order);
 }
 
-void Exchange::enqueue_order(const order_t& order) {
-    std::string sym(order.ticker, TICKER_LEN);
-    auto it = bookThreads_.find(sym);
-    if (it == bookThreads_.end()) {
-      std::cout << "[DEBUG] enqueue_order: no book for " << sym << "\n";
-      return;
+// When the symbol's queue is full, sheds the order under REJECT,
+// otherwise waits for its thread, which is awake while it has orders
+// queued (or queues it regardless once the exchange stops). The queue's
+// size is approximate, so the capacity can be overshot by orders
+// enqueued at the same moment.
+order_result Exchange::enqueue_order(const order_t& order) {
+    const ticker_key_t key = ticker_key(order.ticker);
+    BookThread* const* bt = bookThreads_.find(key);
+    if (!bt) {
+      TRACE(NO_ROUTE, key);
+      return order_result::UNKNOWN_SYMBOL;
     }
-    it->second.order_queue.enqueue(order);
-    std::cout << "[DEBUG] enqueued order to queue for " << sym << "\n";
+    auto& queue = *(*bt)->order_queue;
+    while (queue_capacity_ != 0 && queue.size_approx() >= queue_capacity_) {
+      if (overload_ == overload_policy::REJECT) {
+        TRACE(SHED, key);
+        return order_result::OVERLOADED;
+      }
+      if (!running_.load()) break;
+      std::this_thread::yield();
+    }
+    queue.enqueue(order);
+    (*bt)->waiter.notify();
+    TRACE(ENQUEUED, key);
+    return order_result::SUCCESS;
 }
 
-void Exchange::book_loop(BookThread* bt) {
-    std::cout << "[DEBUG] book_loop started\n";
+void Exchange::book_loop(BookThread* bt, price_band band, int cpu) {
+    TRACE(WORKER_START);
+    // Pin first: the book and queue below are first touched on this
+    // CPU's node
+    if (cpu >= 0 && !pin_current_thread(cpu)) {
+        TRACE(PIN_FAILED, 0, static_cast<uint64_t>(cpu));
+    }
+    bt->book.emplace(book_config_, logger_, band);
+    bt->order_queue = std::make_unique<moodycamel::ConcurrentQueue<order_t>>();
+    bt->ready.store(true, std::memory_order_release);
+    bt->ready.notify_all();
+
     order_t order;
     while (running_.load()) {
-        if (bt->order_queue.try_dequeue(order)) {
-            std::cout << "[DEBUG] book_loop dequeued order id="
-                      << std::string(order.order_id, ORDER_ID_LEN) << "\n";
+        if (bt->order_queue->try_dequeue(order)) {
+            bt->waiter.reset();
+            TRACE(BATCH, 0, 1);
 
             order_id_key key;
             std::memcpy(key.order_id, order.order_id, ORDER_ID_LEN);
@@ -160,7 +135,7 @@ void Exchange::book_loop(BookThread* bt) {
 
             switch (status) {
                 case order_status::NEW:
-                    res = bt->book.add(order);
+                    res = bt->book->add(order);
                     if (res == order_result::SUCCESS) {
                         logger_->log_price_level_update(
                           order.timestamp,
@@ -169,12 +144,11 @@ void Exchange::book_loop(BookThread* bt) {
                           order.qty,
                           static_cast<order_side>(order.side)
                         );
-                        std::cout << "[DEBUG] logged NEW order\n";
                     }
                     break;
 
                 case order_status::CANCELLED:
-                    res = bt->book.cancel(key);
+                    res = bt->book->cancel(key, order.timestamp);
                     if (res == order_result::SUCCESS) {
                         logger_->log_cancel_order(
                           order.timestamp,
@@ -183,13 +157,12 @@ void Exchange::book_loop(BookThread* bt) {
                           order.qty,
                           static_cast<order_side>(order.side)
                         );
-                        std::cout << "[DEBUG] logged CANCEL order\n";
                     }
                     break;
 
                 case order_status::PARTIALLY_FILLED:
                 case order_status::FILLED:
-                    res = bt->book.modify(key, order);
+                    res = bt->book->modify(key, order);
                     if (res == order_result::SUCCESS) {
                         logger_->log_trade_report(
                           order.timestamp,
@@ -199,19 +172,19 @@ void Exchange::book_loop(BookThread* bt) {
                           order.order_id,
                           order.price
                         );
-                        std::cout << "[DEBUG] logged TRADE/MODIFY\n";
                     }
                     break;
 
                 default:
-                    std::cout << "[DEBUG] unknown status\n";
+                    res = order_result::INVALID_STATUS;
                     break;
             }
-
-            bt->book.execute();
+            TRACE(ORDER_APPLIED, ticker_key(order.ticker), order.status, static_cast<uint64_t>(res));
         } else {
-            std::this_thread::sleep_for(1ms);
+            bt->waiter.idle([&] {
+                return bt->order_queue->size_approx() > 0 || !running_.load();
+            });
         }
     }
-    std::cout << "[DEBUG] book_loop exiting\n";
+    TRACE(WORKER_EXIT);
 }
@@ -1,185 +1,587 @@
 #include "local_exchange.h"
+#include "trace.h"
 #include <chrono>
 #include <thread>
 #include <cstring>
-#include <iostream>
 #include <utility>
 #include <algorithm>
-#include <cctype>
+#include <functional>
+#include <span>
 
 using namespace std::chrono_literals;
 
-static constexpr bool ENABLE_DEBUG = false;
-#define DBG(x) do { if (ENABLE_DEBUG) std::cout << "[DEBUG] " << x << std::endl; } while(0)
-
-static const std::vector<std::string> BUCKETS = {
-    "A","B","C","D",
-    "EA-E","EF-Z",
-    "F","G","H",
-    "IA-E","IF-Z",
-    "J","K","L","M","N","O",
-    "PA-E","PF-Z",
-    "Q","R",
-    "SA-E","SF-N","SO-Z",
-    "T","U","V","W","X","Y","Z"
-};
-
-static std::string get_bucket(const std::string& sym) {
-    if (sym.empty()) return "";
-    char c0 = std::toupper(sym[0]);
-    char c1 = sym.size()>1 ? std::toupper(sym[1]) : '\0';
-
-    switch (c0) {
-      case 'E': return (c1>='A' && c1<='E') ? "EA-E" : "EF-Z";
-      case 'I': return (c1>='A' && c1<='E') ? "IA-E" : "IF-Z";
-      case 'P': return (c1>='A' && c1<='E') ? "PA-E" : "PF-Z";
-      case 'S':
-        if      (c1>='A' && c1<='E') return "SA-E";
-        else if (c1>='F' && c1<='N') return "SF-N";
-        else                          return "SO-Z";
-      default:
-        if (c0>='A' && c0<='Z')
-            return std::string(1, c0);
-        return "";
-    }
-}
 
 Exchange::Exchange(logger* logger_ptr,
-                   OrderParser* parser_ptr)
+                   OrderParser* parser_ptr,
+                   const orderbook_config_t& book_config,
+                   const exchange_options_t& options)
   : logger_(logger_ptr)
   , parser_(parser_ptr)
+  , book_config_(book_config)
+  , options_(options)
+  , routing_(new routing_table_t())
+  , shards_(options.shards)
 {
-    DBG("Exchange constructed");
+    workers_.reserve(shards_.workers());
+    for (uint32_t i = 0; i < shards_.workers(); ++i) {
+        workers_.push_back(std::make_unique<ShardWorker>(i, wait_policy_for(i)));
+        auto cap = options_.worker_capacity.find(std::to_string(i));
+        workers_.back()->capacity = cap == options_.worker_capacity.end() ? options_.shard_capacity
+                                                                          : cap->second;
+    }
+    if (logger_ && options_.placement.logger_cpu >= 0 &&
+        !logger_->pin_to_cpu(options_.placement.logger_cpu)) {
+        TRACE(PIN_FAILED, 0, static_cast<uint64_t>(options_.placement.logger_cpu));
+    }
 }
 
 Exchange::~Exchange() {
     stop();
-    DBG("Exchange destructed");
+    // A worker started while stop() ran has exited by now
+    for (auto& w : workers_) {
+      if (w->thread.joinable()) w->thread.join();
+    }
+    delete routing_.load();
+    for (const auto& [epoch, table] : retired_) delete table;
 }
 
 void Exchange::start() {
     running_.store(true);
-    DBG("Exchange::start() – running_=true");
+    TRACE(EXCHANGE_START);
+    // Workers of symbols registered before start()
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    for (const auto& route : routes_) worker(route->worker);
 }
 
 void Exchange::stop() {
     if (!running_.exchange(false)) return;
-    DBG("Exchange::stop() – running_=false");
-    for (auto & [bucket, bt] : bucketThreads_) {
-      if (bt.thread.joinable()) bt.thread.join();
+    TRACE(EXCHANGE_STOP);
+    for (auto& w : workers_) {
+      w->waiter.wake();
+      if (w->thread.joinable()) w->thread.join();
     }
 }
 
-void Exchange::add_symbol(const char* symbol) {
-    std::string sym(symbol, TICKER_LEN);
-    std::string bucket = get_bucket(sym);
-    if (bucket.empty()) {
-      DBG("add_symbol: invalid bucket for " << sym);
-      return;
-    }
-
-    auto [it, inserted] = bucketThreads_.emplace(
-      bucket,
-      BucketThread{}
-    );
-
-    if (inserted) {
-      DBG("creating bucket thread for " << bucket);
-      it->second.thread = std::thread(&Exchange::book_loop, this, &it->second);
+// A symbol has a route once it is registered or has received an order;
+// either way its book may already be built, so its band is settled
+bool Exchange::add_symbol(const char* symbol, const price_band& band) {
+    const ticker_key_t key = ticker_key(std::string_view(symbol, strnlen(symbol, TICKER_LEN)));
+    if (key == 0) return false;
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    if (find_route_locked(key)) return false;
+    {
+      std::lock_guard<std::mutex> bands(bands_mutex_);
+      bands_[key] = band;
     }
+    route_locked(key);
+    TRACE(SYMBOL_ADDED, key, shards_.worker_for(ticker_name(key)));
+    return true;
+}
 
-    auto &bt = it->second;
-    auto [bookIt, added] =
-      bt.books.emplace(sym, orderbook(logger_));
-    if (added) {
-      DBG("added symbol " << sym << " into bucket " << bucket);
-    } else {
-      DBG("symbol " << sym << " already in bucket " << bucket);
+size_t Exchange::add_symbols(const std::vector<std::pair<std::string, price_band>>& symbols) {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    std::vector<route_entry_t> entries;
+    entries.reserve(symbols.size());
+    for (const auto& [symbol, band] : symbols) {
+      const ticker_key_t key = ticker_key(symbol);
+      if (key == 0 || find_route_locked(key)) continue;
+      {
+        // Routes made here are not published yet; the band marks repeats
+        std::lock_guard<std::mutex> bands(bands_mutex_);
+        if (!bands_.try_emplace(key, band).second) continue;
+      }
+      route_t* route = new_route_locked(key);
+      entries.push_back(route_entry_t{route, route->book, route->worker, false});
+      TRACE(SYMBOL_ADDED, key, route->worker);
     }
+    if (!entries.empty()) publish_locked(entries);
+    return entries.size();
 }
 
-void Exchange::on_msg_received(const uint8_t* data, size_t len) {
-    DBG("on_msg_received(len=" << len << ")");
+order_result Exchange::on_msg_received(const uint8_t* data, size_t len) {
+    TRACE(MSG_RECEIVED, 0, len);
     ParsedOrder parsed;
     if (!parser_->parse_message(data, len, parsed)) {
-      DBG("parse_message failed");
-      return;
+      TRACE(PARSE_FAILED, 0, len);
+      return order_result::MALFORMED;
     }
     order_t order = parser_->convert_to_order(parsed);
-    DBG("parsed order id=" << std::string(order.order_id, ORDER_ID_LEN)
-        << " ticker=" << std::string(order.ticker, TICKER_LEN)
-        << " price=" << order.price
-        << " qty=" << order.qty);
-    enqueue_order(order);
+    TRACE(ORDER_PARSED, ticker_key(order.ticker), order.price, order.qty);
+    return enqueue_order(order);
 }
 
-void Exchange::enqueue_order(const order_t& order) {
-    const std::string sym(order.ticker, TICKER_LEN);
-    const std::string bucket = get_bucket(sym);
-    if (bucket.empty()) {
-        DBG("enqueue_order: invalid bucket for " << sym);
-        return;
+order_result Exchange::enqueue_order(const order_t& order) {
+    const ticker_key_t key = ticker_key(order.ticker);
+    if (key == 0) return order_result::MALFORMED;
+
+    // Each attempt to queue happens inside the guard, with the entry read
+    // under it, so migrate()'s grace period covers every order sent
+    // through an old entry. Waiting for a lane or for room happens
+    // outside, then the order is routed again: the symbol may have moved.
+    route_t* slow = nullptr;
+    for (;;) {
+        ShardWorker* w = nullptr;
+        uint32_t book = 0;
+        bool have_lane = false;
+        {
+            auto guard = epochs_.read();
+            const routing_table_t* table = routing_.load(std::memory_order_seq_cst);
+            const route_entry_t* e = table->find(key);
+            if (!e) break;
+            if (e->frozen) {
+                slow = e->route;
+                break;
+            }
+            w = workers_[e->worker].get();
+            book = e->book;
+            if (lane_t* lane = w->lanes[thread_slot()].load(std::memory_order_acquire)) {
+                if (try_push(w, lane, order, book)) return order_result::SUCCESS;
+                have_lane = true;
+            }
+        }
+        if (!have_lane) {
+            lane_for(w);
+            continue;
+        }
+        if (shed(w, order, book)) return order_result::OVERLOADED;
+        std::this_thread::yield();
     }
 
-    auto [bt_it, was_bucket_inserted] =
-        bucketThreads_.emplace(bucket, BucketThread{});
-    BucketThread &bt = bt_it->second;
+    if (!slow) {
+        // First order of an unregistered symbol
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        slow = route_locked(key);
+    }
+    return hold(slow, order);
+}
 
-    if (was_bucket_inserted) {
-        DBG("auto‑creating bucket thread for " << bucket);
-        bt.thread = std::thread(&Exchange::book_loop, this, &bt);
+// Queue an order for `w`. When the lane or shard is full, sheds it
+// (returns false) under REJECT, otherwise waits for the worker, which is
+// awake while it has orders queued.
+bool Exchange::push(ShardWorker* w, const order_t& order, uint32_t book) {
+    lane_t* lane = lane_for(w);
+    while (!try_push(w, lane, order, book)) {
+        if (shed(w, order, book)) return false;
+        std::this_thread::yield();
     }
+    return true;
+}
+
+// One attempt to queue an order on this thread's lane into `w`; fails if
+// the lane or the shard is full
+bool Exchange::try_push(ShardWorker* w, lane_t* lane, const order_t& order, uint32_t book) {
+    const bool shard_full = w->capacity != 0 &&
+                            w->depth.load(std::memory_order_relaxed) >= w->capacity;
+    if (shard_full || !lane->try_push(queued_order_t{order, book})) return false;
+    w->waiter.notify();
+    TRACE(ENQUEUED, ticker_key(order.ticker), book, w->index);
+    return true;
+}
+
+// After a failed attempt: under REJECT count the order as shed and
+// return true, otherwise false (keep trying)
+bool Exchange::shed(ShardWorker* w, [[maybe_unused]] const order_t& order,
+                    [[maybe_unused]] uint32_t book) {
+    if (options_.overload != overload_policy::REJECT) return false;
+    w->rejected.fetch_add(1, std::memory_order_relaxed);
+    TRACE(SHED, ticker_key(order.ticker), book, w->index);
+    return true;
+}
 
-    auto [book_it, was_book_inserted] =
-        bt.books.emplace(sym, orderbook(logger_));
-    if (was_book_inserted) {
-        DBG("auto‑adding book for symbol " << sym << " into bucket " << bucket);
+// This thread's lane into `w`. On its first send the thread asks the
+// worker to build the lane and waits for it, unless the exchange is not
+// running and no worker will answer.
+Exchange::lane_t* Exchange::lane_for(ShardWorker* w) {
+    const size_t slot = thread_slot();
+    lane_t* lane = w->lanes[slot].load(std::memory_order_acquire);
+    if (lane) return lane;
+
+    if (running_.load()) {
+        post(w, control_t{control_t::kind::LANE, static_cast<uint32_t>(slot), nullptr, {}, {}});
+        while (!(lane = w->lanes[slot].load(std::memory_order_acquire))) {
+            if (!running_.load()) break;
+            std::this_thread::yield();
+        }
+        if (lane) return lane;
     }
+    return install_lane(w, slot, new lane_t(options_.lane_capacity));
+}
 
-    bt.order_queue.enqueue(order);
-    DBG("enqueued order for " << sym << " into bucket " << bucket);
+// Publish `lane` as slot's lane unless one is already there; returns the
+// lane in place
+Exchange::lane_t* Exchange::install_lane(ShardWorker* w, size_t slot, lane_t* lane) {
+    lane_t* existing = nullptr;
+    if (!w->lanes[slot].compare_exchange_strong(existing, lane, std::memory_order_acq_rel)) {
+        delete lane;
+        return existing;
+    }
+    size_t count = w->lane_count.load(std::memory_order_relaxed);
+    while (count <= slot &&
+           !w->lane_count.compare_exchange_weak(count, slot + 1, std::memory_order_release)) {
+    }
+    TRACE(NEW_LANE, 0, slot, w->index);
+    return lane;
 }
 
-void Exchange::book_loop(BucketThread* bt) {
-    DBG("bucket thread started");
-    order_t order;
-    while (running_.load()) {
-        if (bt->order_queue.try_dequeue(order)) {
-            std::string sym(order.ticker, TICKER_LEN);
-            auto bookIt = bt->books.find(sym);
-            if (bookIt == bt->books.end()) {
-                DBG("no orderbook for " << sym);
-                continue;
-            }
+// Worker: take up to `max` orders, visiting lanes round-robin from `next`
+size_t Exchange::poll_lanes(ShardWorker* w, queued_order_t* out, size_t max, size_t& next) {
+    const size_t count = w->lane_count.load(std::memory_order_acquire);
+    if (count == 0) return 0;
+    if (next >= count) next = 0;
+
+    // Depth over all lanes before taking this batch; only written when it
+    // changes, so an idle worker leaves the line clean in producers' caches
+    uint64_t depth = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (const lane_t* lane = w->lanes[i].load(std::memory_order_acquire)) depth += lane->size();
+    }
+    if (depth != w->depth.load(std::memory_order_relaxed)) {
+        w->depth.store(depth, std::memory_order_relaxed);
+        if (depth > w->depth_high_water.load(std::memory_order_relaxed)) {
+            w->depth_high_water.store(depth, std::memory_order_relaxed);
+        }
+    }
+
+    size_t n = 0;
+    for (size_t k = 0; k < count && n < max; ++k) {
+        size_t i = next + k;
+        if (i >= count) i -= count;
+        if (lane_t* lane = w->lanes[i].load(std::memory_order_acquire)) {
+            n += lane->try_pop_bulk(out + n, max - n);
+        }
+    }
+    next = next + 1 < count ? next + 1 : 0;
+    return n;
+}
+
+bool Exchange::lanes_empty(const ShardWorker* w) const {
+    const size_t count = w->lane_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        const lane_t* lane = w->lanes[i].load(std::memory_order_acquire);
+        if (lane && !lane->empty()) return false;
+    }
+    return true;
+}
+
+// Slow path, after seeing a frozen entry (or none): hold the order while
+// the route is migrating, otherwise send it where the route now points.
+// migrate() flushes held orders before it publishes the thawed entry.
+order_result Exchange::hold(route_t* route, const order_t& order) {
+    std::lock_guard<std::mutex> lock(route->held_mutex);
+    if (route->frozen) {
+        route->held.push_back(order);
+        TRACE(HELD, route->ticker, route->book);
+        return order_result::SUCCESS;
+    }
+    return push(workers_[route->worker].get(), order, route->book)
+        ? order_result::SUCCESS : order_result::OVERLOADED;
+}
+
+Exchange::route_t* Exchange::find_route_locked(ticker_key_t ticker) const {
+    const route_entry_t* e = routing_.load(std::memory_order_relaxed)->find(ticker);
+    return e ? e->route : nullptr;
+}
+
+// A route for `ticker` with the worker the shard map gives it, not yet
+// published. While the exchange runs, that worker is started before the
+// route can be visible, so producers never wait for a thread.
+Exchange::route_t* Exchange::new_route_locked(ticker_key_t ticker) {
+    auto route = std::make_unique<route_t>();
+    route->ticker = ticker;
+    route->book = static_cast<uint32_t>(routes_.size());
+    route->worker = shards_.worker_for(ticker_name(ticker));
+    worker(route->worker);
+    routes_.push_back(std::move(route));
+    return routes_.back().get();
+}
+
+// Route for `ticker`, created and published on first use
+Exchange::route_t* Exchange::route_locked(ticker_key_t ticker) {
+    if (route_t* route = find_route_locked(ticker)) return route;
+    route_t* route = new_route_locked(ticker);
+    publish_locked(*route, route->worker, false);
+    return route;
+}
+
+// Copy the table with `entries` replaced, swap it in and retire the old
+// one. Producers may still be reading it, so it is freed by a later
+// publish, as are earlier tables no producer can still be reading; one
+// copy and no waiting however many entries change.
+void Exchange::publish_locked(std::span<const route_entry_t> entries) {
+    const routing_table_t* old = routing_.load(std::memory_order_relaxed);
+    auto* next = new routing_table_t(*old);
+    for (const route_entry_t& e : entries) next->insert(e.route->ticker, e);
+    routing_.store(next, std::memory_order_seq_cst);
+    retired_.emplace_back(epochs_.advance(), old);
+    std::erase_if(retired_, [&](const auto& r) {
+        if (!epochs_.quiescent(r.first)) return false;
+        delete r.second;
+        return true;
+    });
+}
+
+void Exchange::publish_locked(route_t& route, uint32_t worker, bool frozen) {
+    const route_entry_t entry{&route, route.book, worker, frozen};
+    publish_locked(std::span<const route_entry_t>(&entry, 1));
+}
+
+// The worker's thread, started on first use while the exchange runs (a
+// worker would exit at once otherwise; start() starts those needed
+// earlier). Returns once the thread has been placed.
+Exchange::ShardWorker* Exchange::worker(uint32_t index) {
+    ShardWorker* w = workers_[index].get();
+    if (!running_.load()) return w;
+    std::call_once(w->started, [&] {
+        TRACE(WORKER_START, 0, index);
+        w->thread = std::thread(&Exchange::book_loop, this, w,
+                                options_.placement.cpu_for(std::to_string(index)));
+    });
+    w->ready.wait(false, std::memory_order_acquire);
+    return w;
+}
+
+// Book for a queued order, built on first use on the worker
+orderbook& Exchange::book_for(ShardWorker* w, const queued_order_t& q) {
+    if (q.book < w->books.size() && w->books[q.book]) return *w->books[q.book];
 
-            DBG("dequeued order for " << sym);
-            order_id_key key;
-            std::memcpy(key.order_id, order.order_id, ORDER_ID_LEN);
-
-            auto status = static_cast<order_status>(order.status);
-            order_result res;
-
-            switch (status) {
-                case order_status::NEW:
-                    res = bookIt->second.add(order);
-                    break;
-                case order_status::CANCELLED:
-                    res = bookIt->second.cancel(key);
-                    break;
-                case order_status::PARTIALLY_FILLED:
-                case order_status::FILLED:
-                    res = bookIt->second.modify(key, order);
-                    break;
-                default:
-                    DBG("unknown status");
-                    break;
+    price_band band;
+    {
+        std::lock_guard<std::mutex> lock(bands_mutex_);
+        auto b = bands_.find(ticker_key(q.order.ticker));
+        if (b != bands_.end()) band = b->second;
+    }
+    TRACE(BOOK_BUILT, ticker_key(q.order.ticker), q.book);
+    if (q.book >= w->books.size()) w->books.resize(q.book + 1);
+    w->books[q.book] = std::make_unique<orderbook>(book_config_, logger_, band);
+    return *w->books[q.book];
+}
+
+// Worker: count `n` orders applied to q's book. The route is looked up
+// in the routing table the first time the worker sees the book.
+void Exchange::count_applied(ShardWorker* w, const queued_order_t& q, size_t n) {
+    if (q.book >= w->routes.size()) w->routes.resize(q.book + 1, nullptr);
+    route_t*& route = w->routes[q.book];
+    if (!route) {
+        auto guard = epochs_.read();
+        route = routing_.load(std::memory_order_seq_cst)->find(ticker_key(q.order.ticker))->route;
+    }
+    route->msgs.store(route->msgs.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void Exchange::post(ShardWorker* w, control_t cmd) {
+    {
+        std::lock_guard<std::mutex> lock(w->control_mutex);
+        w->control.push_back(std::move(cmd));
+    }
+    w->has_control.store(true, std::memory_order_release);
+    w->waiter.notify();
+}
+
+// Worker: carry out migration steps. Runs between batches, so no book is
+// in use.
+void Exchange::run_control(ShardWorker* w) {
+    std::vector<control_t> cmds;
+    {
+        std::lock_guard<std::mutex> lock(w->control_mutex);
+        cmds.swap(w->control);
+        w->has_control.store(false, std::memory_order_relaxed);
+    }
+    for (control_t& cmd : cmds) {
+        std::unique_ptr<orderbook> out;
+        if (cmd.what == control_t::kind::LANE) {
+            // Built here so the ring is first touched on this node
+            install_lane(w, cmd.book, new lane_t(options_.lane_capacity));
+            continue;
+        }
+        if (cmd.what == control_t::kind::RELEASE) {
+            if (cmd.book < w->books.size()) out = std::move(w->books[cmd.book]);
+            TRACE(BOOK_RELEASED, 0, cmd.book);
+        } else {
+            if (cmd.built) {
+                if (cmd.book >= w->books.size()) w->books.resize(cmd.book + 1);
+                w->books[cmd.book] = std::move(cmd.built);
             }
+            // Orders held during the move, before anything sent since
+            if (!cmd.held.empty()) {
+                const queued_order_t first{cmd.held.front(), cmd.book};
+                book_for(w, first).apply_batch(cmd.held);
+                count_applied(w, first, cmd.held.size());
+            }
+            TRACE(BOOK_ADOPTED, 0, cmd.book, cmd.held.size());
+        }
+        cmd.done.set_value(std::move(out));
+    }
+}
+
+bool Exchange::migrate(const std::string& symbol, uint32_t to) {
+    if (to >= workers_.size() || !running_.load()) return false;
+    const ticker_key_t key = ticker_key(symbol);
+    if (key == 0) return false;
 
-            bookIt->second.execute();
+    std::lock_guard<std::mutex> registry(registry_mutex_);
+    route_t* route = route_locked(key);
+    const uint32_t from = route->worker;   // only changes under registry_mutex_
+    if (from == to) return true;
+
+    {
+        std::lock_guard<std::mutex> lock(route->held_mutex);
+        route->frozen = true;
+    }
+    // After the grace period no producer is still sending to `from`
+    // through the old entry, so every order for the symbol sent there is
+    // in a lane below the positions read here
+    publish_locked(*route, from, true);
+    epochs_.synchronize();
+    ShardWorker* src = workers_[from].get();
+    std::vector<std::pair<const lane_t*, uint64_t>> drained;
+    for (size_t i = 0; i < src->lane_count.load(std::memory_order_acquire); ++i) {
+        if (const lane_t* lane = src->lanes[i].load(std::memory_order_acquire)) {
+            drained.emplace_back(lane, lane->pushed());
         }
-        else {
-            std::this_thread::sleep_for(1ms);
+    }
+
+    // Safe point: `from` has taken all of those off its lanes. It handles
+    // the release after the batch they are in, so none is left unapplied.
+    for (const auto& [lane, pos] : drained) {
+        while (lane->popped() < pos) std::this_thread::yield();
+    }
+
+    control_t release{control_t::kind::RELEASE, route->book, nullptr, {}, {}};
+    auto released = release.done.get_future();
+    post(src, std::move(release));
+    std::unique_ptr<orderbook> built = released.get();
+
+    // The destination adopts the book and applies the held orders before
+    // the route thaws. Producers that saw the frozen entry wait on
+    // held_mutex meanwhile, then find the route thawed and follow it.
+    ShardWorker* dst = worker(to);
+    {
+        std::lock_guard<std::mutex> lock(route->held_mutex);
+        TRACE(MIGRATING, key, from, to);
+        control_t adopt{control_t::kind::ADOPT, route->book, std::move(built),
+                        std::move(route->held), {}};
+        route->held.clear();
+        auto adopted = adopt.done.get_future();
+        post(dst, std::move(adopt));
+        adopted.wait();
+        route->worker = to;
+        route->frozen = false;
+    }
+    publish_locked(*route, to, false);
+    shards_.assign(ticker_name(key), to);
+    return true;
+}
+
+std::vector<symbol_load> Exchange::symbol_loads() const {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    std::vector<symbol_load> loads;
+    loads.reserve(routes_.size());
+    for (const auto& route : routes_) {
+        const uint64_t msgs = route->msgs.load(std::memory_order_relaxed);
+        loads.push_back({ticker_name(route->ticker), msgs - route->msgs_at_rebalance});
+    }
+    return loads;
+}
+
+size_t Exchange::rebalance(double tolerance, size_t max_moves) {
+    const std::vector<symbol_load> loads = symbol_loads();
+    const std::vector<shard_move> moves = current_shards().plan_moves(loads, tolerance, max_moves);
+
+    size_t moved = 0;
+    for (const shard_move& m : moves) {
+        if (migrate(m.symbol, m.to)) ++moved;
+    }
+
+    // Next call measures from here
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    for (size_t i = 0; i < loads.size(); ++i) {
+        routes_[i]->msgs_at_rebalance += loads[i].rate;
+    }
+    return moved;
+}
+
+shard_map Exchange::current_shards() const {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    return shards_;
+}
+
+void Exchange::book_loop(ShardWorker* w, int cpu) {
+    // Pin first: everything below is first touched on this CPU's node
+    if (cpu >= 0 && !pin_current_thread(cpu)) {
+        TRACE(PIN_FAILED, 0, static_cast<uint64_t>(cpu));
+    }
+    w->ready.store(true, std::memory_order_release);
+    w->ready.notify_all();
+
+    const size_t cap = std::max<size_t>(1, options_.max_batch);
+    std::vector<queued_order_t> batch(cap);
+    std::vector<order_t> grouped(cap);
+    std::vector<std::pair<orderbook*, uint32_t>> routed;
+    routed.reserve(cap);
+    size_t next_lane = 0;
+
+    while (running_.load()) {
+        if (w->has_control.load(std::memory_order_acquire)) run_control(w);
+
+        const size_t n = poll_lanes(w, batch.data(), cap, next_lane);
+        if (n == 0) {
+            w->waiter.idle([&] {
+                return !lanes_empty(w) ||
+                       w->has_control.load(std::memory_order_acquire) ||
+                       !running_.load();
+            });
+            continue;
+        }
+        w->waiter.reset();
+        w->batch_sizes.record(n);
+        TRACE(BATCH, 0, n, w->index);
+
+        // Route each order to its book, then group the batch by book
+        // keeping arrival order within each book
+        routed.clear();
+        orderbook* book = nullptr;
+        for (size_t i = 0; i < n; ++i) {
+            if (i == 0 || batch[i].book != batch[i - 1].book) book = &book_for(w, batch[i]);
+            routed.emplace_back(book, static_cast<uint32_t>(i));
+        }
+        std::stable_sort(routed.begin(), routed.end(),
+                         [](const auto& a, const auto& b) { return std::less<>{}(a.first, b.first); });
+
+        // One apply_batch per affected book: it matches each order as it
+        // arrives and hands the book's events to the logger in one push
+        for (size_t begin = 0; begin < routed.size();) {
+            size_t end = begin;
+            for (; end < routed.size() && routed[end].first == routed[begin].first; ++end) {
+                grouped[end - begin] = batch[routed[end].second].order;
+            }
+            routed[begin].first->apply_batch(std::span<const order_t>(grouped.data(), end - begin));
+            count_applied(w, batch[routed[begin].second], end - begin);
+            begin = end;
         }
     }
-    DBG("bucket thread exiting");
+    TRACE(WORKER_EXIT, 0, w->index);
+}
+
+log2_histogram::snapshot_t Exchange::batch_size_histogram() const {
+    log2_histogram::snapshot_t total{};
+    for (const auto& w : workers_) {
+        w->batch_sizes.accumulate(total);
+    }
+    return total;
+}
+
+std::vector<shard_stats_t> Exchange::shard_stats() const {
+    std::vector<shard_stats_t> stats;
+    stats.reserve(workers_.size());
+    for (const auto& w : workers_) {
+        stats.push_back({w->depth.load(std::memory_order_relaxed),
+                         w->depth_high_water.load(std::memory_order_relaxed),
+                         w->rejected.load(std::memory_order_relaxed)});
+    }
+    return stats;
+}
+
+wait_policy Exchange::wait_policy_for(uint32_t worker) const {
+    auto it = options_.worker_wait.find(std::to_string(worker));
+    return it == options_.worker_wait.end() ? options_.wait : it->second;
 }
@@ -0,0 +1,43 @@
+// log_decode.cpp
+//
+// Rewrites a binary log (logger with log_format::BINARY) as the JSON
+// lines the JSON format would have written.
+//
+// Usage: hft-log-decode <binary log> [json out]   (default: stdout)
+
+#include <exception>
+#include <fstream>
+#include <iostream>
+
+#include "logger.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "usage: " << argv[0] << " <binary log> [json out]\n";
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "cannot open " << argv[1] << "\n";
+        return 1;
+    }
+    std::ofstream file;
+    if (argc == 3) {
+        file.open(argv[2]);
+        if (!file) {
+            std::cerr << "cannot open " << argv[2] << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = argc == 3 ? file : std::cout;
+
+    try {
+        const size_t n = decode_log(in, out);
+        std::cerr << n << " records\n";
+    } catch (const std::exception& e) {
+        std::cerr << argv[1] << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,14 +1,30 @@
 #include "logger.h"
+#include "thread_affinity.h"
 #include <stdexcept>
 #include <cstring>
 #include <chrono>
+#include <istream>
+#include <ostream>
 #include <sstream>
 
-logger::logger(const std::string& filename) : running_(true) {
-    out_file_.open(filename);
+logger::logger(const std::string& filename, log_format format)
+  : running_(true), format_(format) {
+    if (format_ == log_format::BINARY) {
+        out_file_.open(filename, std::ios::binary);
+    } else {
+        out_file_.open(filename);
+    }
     if (!out_file_.is_open()) {
         throw std::runtime_error("Failed to open log file: " + filename);
     }
+    if (format_ == log_format::BINARY) {
+        log_file_header_t header{};
+        std::memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+        header.version = LOG_FORMAT_VERSION;
+        header.record_size = sizeof(log_record_t);
+        out_file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        buffer_ = std::make_unique<log_record_t[]>(BUFFER_RECORDS);
+    }
     thread_ = std::thread(&logger::run, this);
 }
 
@@ -33,11 +49,43 @@ logger::~logger() {
 }
 
 void logger::push(const log_event_t& event) {
+    pushed_.fetch_add(1, std::memory_order_relaxed);
     queue_.enqueue(event);
     std::lock_guard<std::mutex> lock(mutex_);
     cv_.notify_one();
 }
 
+void logger::push_bulk(const log_event_t* events, size_t count) {
+    if (count == 0) return;
+    pushed_.fetch_add(count, std::memory_order_relaxed);
+    queue_.enqueue_bulk(events, count);
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_one();
+}
+
+void logger::flush() {
+    const uint64_t target = pushed_.load(std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (flush_target_.load(std::memory_order_relaxed) < target) {
+        flush_target_.store(target, std::memory_order_relaxed);
+    }
+    cv_.notify_one();
+    drained_cv_.wait(lock, [&] {
+        return !running_ || written_.load(std::memory_order_acquire) >= target;
+    });
+}
+
+bool logger::pin_to_cpu(int cpu) {
+    return pin_thread(thread_, cpu);
+}
+
+// External ID for a log line; all zeros if the caller has none
+static order_id_key external_id(const char* id) {
+    order_id_key key{};
+    if (id) std::memcpy(key.order_id, id, ORDER_ID_LEN);
+    return key;
+}
+
 void logger::log_price_level_update(uint64_t ts,
                                     const char* ord_id,
                                     uint32_t price,
@@ -46,7 +94,7 @@ void logger::log_price_level_update(uint64_t ts,
     log_event_t ev;
     ev.timestamp = ts;
     ev.kind = log_event_kind::PRICE_LEVEL_UPDATE;
-    std::memcpy(ev.order_id, ord_id, ORDER_ID_LEN);
+    ev.id = external_id(ord_id);
     ev.price = price;
     ev.qty   = qty;
     ev.side  = side;
@@ -62,13 +110,13 @@ void logger::log_trade_report(uint64_t ts,
     log_event_t ev;
     ev.timestamp = ts;
     ev.kind = log_event_kind::TRADE_REPORT;
+    ev.id = external_id(buy_id);
+    ev.id_secondary = external_id(sell_id);
 
-    std::memcpy(ev.order_id, buy_id, ORDER_ID_LEN);
     ev.price = buy_price;
     ev.qty = matched_qty;
     ev.side = order_side::BUY;
 
-    std::memcpy(ev.order_id_secondary, sell_id, ORDER_ID_LEN);
     ev.price_secondary = sell_price;
     ev.qty_secondary   = matched_qty;
     ev.side_secondary  = order_side::SELL;
@@ -88,13 +136,13 @@ void logger::log_modify_order(uint64_t ts,
     log_event_t ev;
     ev.timestamp = ts;
     ev.kind = log_event_kind::MODIFY;
+    ev.id = external_id(new_id);
+    ev.id_secondary = external_id(old_id);
 
-    std::memcpy(ev.order_id, new_id, ORDER_ID_LEN);
     ev.price = new_price;
     ev.qty   = new_qty;
     ev.side  = new_side;
 
-    std::memcpy(ev.order_id_secondary, old_id, ORDER_ID_LEN);
     ev.price_secondary = old_price;
     ev.qty_secondary   = old_qty;
     ev.side_secondary  = old_side;
@@ -103,25 +151,41 @@ void logger::log_modify_order(uint64_t ts,
 }
 
 void logger::log_cancel_order(uint64_t ts,
-                                const char* ord_id,
+                              const char* ord_id,
                               uint32_t price,
                               size_t qty,
                               order_side side) {
     log_event_t ev;
     ev.timestamp = ts;
     ev.kind = log_event_kind::CANCEL;
-    std::memcpy(ev.order_id, ord_id, ORDER_ID_LEN);
+    ev.id = external_id(ord_id);
     ev.price = price;
     ev.qty   = qty;
     ev.side  = side;
     push(ev);
 }
 
-std::string logger::event_to_line(const log_event_t& ev) {
+log_record_t to_log_record(const log_event_t& ev) {
+    log_record_t rec{};
+    rec.timestamp = ev.timestamp;
+    rec.qty = ev.qty;
+    rec.qty_secondary = ev.qty_secondary;
+    rec.price = ev.price;
+    rec.price_secondary = ev.price_secondary;
+    rec.version = LOG_FORMAT_VERSION;
+    rec.kind = ev.kind;
+    rec.side = ev.side;
+    rec.side_secondary = ev.side_secondary;
+    std::memcpy(rec.order_id, ev.id.order_id, ORDER_ID_LEN);
+    std::memcpy(rec.order_id_secondary, ev.id_secondary.order_id, ORDER_ID_LEN);
+    return rec;
+}
+
+std::string log_record_to_json(const log_record_t& rec) {
     std::ostringstream oss;
     oss << "{";
 
-    switch (ev.kind) {
+    switch (rec.kind) {
     case log_event_kind::PRICE_LEVEL_UPDATE:
         oss << "\"type\":\"price_level_update\"";
         break;
@@ -136,46 +200,112 @@ std::string logger::event_to_line(const log_event_t& ev) {
         break;
     }
 
-    oss << ",\"timestamp\":" << ev.timestamp;
-    oss << ",\"order_id\":\"" << std::string(ev.order_id, ORDER_ID_LEN) << "\"";
-    oss << ",\"price\":" << ev.price;
-    oss << ",\"qty\":" << ev.qty;
-    oss << ",\"side\":" << static_cast<int>(ev.side);
+    oss << ",\"timestamp\":" << rec.timestamp;
+    oss << ",\"order_id\":\"";
+    oss.write(rec.order_id, ORDER_ID_LEN);
+    oss << "\"";
+    oss << ",\"price\":" << rec.price;
+    oss << ",\"qty\":" << rec.qty;
+    oss << ",\"side\":" << static_cast<int>(rec.side);
 
-    if (ev.kind == log_event_kind::TRADE_REPORT || ev.kind == log_event_kind::MODIFY) {
-        oss << ",\"order_id_secondary\":\"" 
-            << std::string(ev.order_id_secondary, ORDER_ID_LEN) << "\"";
-        oss << ",\"price_secondary\":" << ev.price_secondary;
-        oss << ",\"qty_secondary\":" << ev.qty_secondary;
-        oss << ",\"side_secondary\":" << static_cast<int>(ev.side_secondary);
+    if (rec.kind == log_event_kind::TRADE_REPORT || rec.kind == log_event_kind::MODIFY) {
+        oss << ",\"order_id_secondary\":\"";
+        oss.write(rec.order_id_secondary, ORDER_ID_LEN);
+        oss << "\"";
+        oss << ",\"price_secondary\":" << rec.price_secondary;
+        oss << ",\"qty_secondary\":" << rec.qty_secondary;
+        oss << ",\"side_secondary\":" << static_cast<int>(rec.side_secondary);
     }
 
     oss << "}";
     return oss.str();
 }
 
+size_t decode_log(std::istream& in, std::ostream& out) {
+    log_file_header_t header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+        throw std::runtime_error("not a binary log");
+    }
+    if (header.version != LOG_FORMAT_VERSION || header.record_size != sizeof(log_record_t)) {
+        throw std::runtime_error("unsupported binary log version " + std::to_string(header.version));
+    }
+
+    size_t n = 0;
+    log_record_t rec;
+    while (in.read(reinterpret_cast<char*>(&rec), sizeof(rec))) {
+        out << log_record_to_json(rec) << "\n";
+        ++n;
+    }
+    if (in.gcount() != 0) {
+        throw std::runtime_error("truncated record after " + std::to_string(n) + " records");
+    }
+    return n;
+}
+
+std::string logger::event_to_line(const log_event_t& ev) {
+    return log_record_to_json(to_log_record(ev));
+}
+
+void logger::write_events(const log_event_t* events, size_t count) {
+    if (format_ == log_format::JSON) {
+        for (size_t i = 0; i < count; ++i) out_file_ << event_to_line(events[i]) << "\n";
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (buffered_ == BUFFER_RECORDS) write_buffer();
+        buffer_[buffered_++] = to_log_record(events[i]);
+    }
+}
+
+void logger::write_buffer() {
+    if (buffered_ == 0) return;
+    out_file_.write(reinterpret_cast<const char*>(buffer_.get()),
+                    static_cast<std::streamsize>(buffered_ * sizeof(log_record_t)));
+    buffered_ = 0;
+}
+
 void logger::run() {
+    using clock = std::chrono::steady_clock;
+    static constexpr size_t BATCH = 256;
+    log_event_t batch[BATCH];
+    // Events appended since the last flush; full binary buffers are
+    // written out as they fill, but the file is flushed only when due
+    uint64_t held = 0;
+    clock::time_point last_flush = clock::now();
+    auto flush_wanted = [&] {
+        return written_.load(std::memory_order_relaxed) < flush_target_.load(std::memory_order_relaxed);
+    };
     while (true) {
-        log_event_t ev;
-        bool did_work = false;
-        while (queue_.try_dequeue(ev)) {
-            did_work = true;
-            out_file_ << event_to_line(ev) << "\n";
+        for (size_t k; (k = queue_.try_dequeue_bulk(batch, BATCH)) != 0; held += k) {
+            write_events(batch, k);
         }
-        if (did_work) {
+        const bool due = held && (flush_wanted() || clock::now() - last_flush >= FLUSH_INTERVAL);
+        if (due) {
+            write_buffer();
             out_file_.flush();
+            last_flush = clock::now();
         }
 
         std::unique_lock<std::mutex> lock(mutex_);
+        if (due) {
+            written_.fetch_add(held, std::memory_order_release);
+            held = 0;
+            drained_cv_.notify_all();
+        }
         if (!running_) {
             break;
         }
-        cv_.wait_for(lock, std::chrono::milliseconds(100));
+        // Recheck under the lock so a push() or flush() between the drain
+        // and here is not left waiting for the timeout
+        if (queue_.size_approx() == 0 && !(held && flush_wanted())) {
+            cv_.wait_until(lock, held ? last_flush + FLUSH_INTERVAL : clock::now() + FLUSH_INTERVAL);
+        }
     }
 
-    log_event_t ev;
-    while (queue_.try_dequeue(ev)) {
-        out_file_ << event_to_line(ev) << "\n";
+    for (size_t k; (k = queue_.try_dequeue_bulk(batch, BATCH)) != 0;) {
+        write_events(batch, k);
     }
+    write_buffer();
     out_file_.flush();
 }
@@ -1,5 +1,7 @@
 // market_data_publisher.cpp
 #include "market_data_publisher.h"
+#include "orderbook_impl.h"
+#include "thread_affinity.h"
 #include <thread>
 #include <chrono>
 
@@ -24,6 +26,7 @@ void MarketDataPublisher::start() {
     bool expected = false;
     if (running_.compare_exchange_strong(expected, true)) {
         thread_ = std::thread(&MarketDataPublisher::run, this);
+        if (cpu_ >= 0) pin_thread(thread_, cpu_);
     }
 }
 
@@ -37,6 +40,10 @@ void MarketDataPublisher::stop() {
     }
 }
 
+void MarketDataPublisher::set_cpu(int cpu) {
+    cpu_ = cpu;
+}
+
 // Each of these just enqueues an event
 void MarketDataPublisher::publish_price_level_update(const PriceLevelUpdateMD& plu) {
     updateQueue_.enqueue(MarketDataEvent{MarketInfoType::PRICE_LEVEL_UPDATE, plu});
@@ -65,3 +72,31 @@ void MarketDataPublisher::run() {
     MarketDataEvent ev;
     while (updateQueue_.try_dequeue(ev)) {}
 }
+
+void publisher_sink::emit(const log_event_t& ev) {
+    switch (ev.kind) {
+    case log_event_kind::PRICE_LEVEL_UPDATE:
+        publisher_->publish_price_level_update(
+            PriceLevelUpdateMD{ev.timestamp, ev.id, ev.price, ev.qty, ev.side});
+        break;
+    case log_event_kind::TRADE_REPORT:
+        publisher_->publish_trade_report(
+            TradeReportMD{ev.timestamp, ev.id, ev.price, ev.qty, ev.side,
+                          ev.id_secondary,
+                          ev.price_secondary, ev.qty_secondary, ev.side_secondary});
+        break;
+    case log_event_kind::MODIFY:
+        publisher_->publish_modify_event(
+            ModifyMD{ev.timestamp, ev.id, ev.price, ev.qty, ev.side,
+                     ev.id_secondary,
+                     ev.price_secondary, ev.qty_secondary, ev.side_secondary});
+        break;
+    case log_event_kind::CANCEL:
+        publisher_->publish_cancel_event(
+            CancelMD{ev.timestamp, ev.id, ev.price, ev.qty, ev.side});
+        break;
+    }
+}
+
+// Book configuration that publishes market data directly
+template class basic_orderbook<publisher_sink>;
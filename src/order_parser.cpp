@@ -63,7 +63,11 @@ bool OrderParser::parse_message(const uint8_t* data, size_t len,
     }
 
     // ── 6) Sanity check for priced orders ─────────────────────────────────
-    if (out.msg_type != TYPE_CANCEL && (out.price == 0 || out.qty == 0))
+    // Market orders take any price, so only their size must be set.
+    const bool is_market = (out.msg_type == TYPE_MARKET_BUY ||
+                            out.msg_type == TYPE_MARKET_SELL);
+    if (out.msg_type != TYPE_CANCEL &&
+        (out.qty == 0 || (out.price == 0 && !is_market)))
         return false;
 
     return true;
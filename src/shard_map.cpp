@@ -0,0 +1,109 @@
+#include "shard_map.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+shard_map::shard_map(uint32_t workers) : workers_(std::max<uint32_t>(1, workers)) {}
+
+uint32_t shard_map::worker_for(const std::string& symbol) const {
+    auto it = assigned_.find(symbol);
+    if (it != assigned_.end()) return it->second;
+
+    // FNV-1a, so unassigned symbols land on the same worker everywhere
+    uint32_t h = 2166136261u;
+    for (unsigned char c : symbol) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h % workers_;
+}
+
+void shard_map::assign(const std::string& symbol, uint32_t worker) {
+    assigned_[symbol] = worker % workers_;
+}
+
+shard_map shard_map::load(const std::string& path, uint32_t workers) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Failed to open shard map: " + path);
+
+    shard_map map(workers);
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string symbol;
+        if (!(fields >> symbol)) continue;   // blank or comment
+
+        uint32_t worker;
+        std::string extra;
+        if (!(fields >> worker) || (fields >> extra)) {
+            throw std::runtime_error("Bad shard map line " + std::to_string(line_no) + " in " + path);
+        }
+        map.assign(symbol, worker);
+    }
+    return map;
+}
+
+void shard_map::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to write shard map: " + path);
+
+    std::vector<std::pair<std::string, uint32_t>> sorted(assigned_.begin(), assigned_.end());
+    std::sort(sorted.begin(), sorted.end());
+    out << "# symbol worker (" << workers_ << " workers)\n";
+    for (const auto& [symbol, worker] : sorted) out << symbol << ' ' << worker << '\n';
+}
+
+shard_map shard_map::balance(std::vector<symbol_load> loads, uint32_t workers) {
+    shard_map map(workers);
+    std::sort(loads.begin(), loads.end(), [](const symbol_load& a, const symbol_load& b) {
+        return a.rate != b.rate ? a.rate > b.rate : a.symbol < b.symbol;
+    });
+
+    std::vector<uint64_t> load(map.workers_, 0);
+    for (const symbol_load& s : loads) {
+        const auto w = static_cast<uint32_t>(std::min_element(load.begin(), load.end()) - load.begin());
+        load[w] += s.rate;
+        map.assigned_[s.symbol] = w;
+    }
+    return map;
+}
+
+std::vector<shard_move> shard_map::plan_moves(const std::vector<symbol_load>& loads,
+                                              double tolerance,
+                                              size_t max_moves) const {
+    std::vector<uint64_t> load(workers_, 0);
+    std::vector<uint32_t> where(loads.size());
+    uint64_t total = 0;
+    for (size_t i = 0; i < loads.size(); ++i) {
+        where[i] = worker_for(loads[i].symbol);
+        load[where[i]] += loads[i].rate;
+        total += loads[i].rate;
+    }
+    const double limit = static_cast<double>(total) / workers_ * (1.0 + tolerance);
+
+    std::vector<shard_move> moves;
+    while (moves.size() < max_moves) {
+        const auto hot = static_cast<uint32_t>(std::max_element(load.begin(), load.end()) - load.begin());
+        const auto cold = static_cast<uint32_t>(std::min_element(load.begin(), load.end()) - load.begin());
+        if (static_cast<double>(load[hot]) <= limit) break;
+
+        // Largest symbol on `hot` no bigger than half the gap
+        const uint64_t half_gap = (load[hot] - load[cold]) / 2;
+        size_t best = loads.size();
+        for (size_t i = 0; i < loads.size(); ++i) {
+            if (where[i] != hot || loads[i].rate == 0 || loads[i].rate > half_gap) continue;
+            if (best == loads.size() || loads[i].rate > loads[best].rate) best = i;
+        }
+        if (best == loads.size()) break;
+
+        moves.push_back(shard_move{loads[best].symbol, hot, cold});
+        load[hot] -= loads[best].rate;
+        load[cold] += loads[best].rate;
+        where[best] = cold;
+    }
+    return moves;
+}
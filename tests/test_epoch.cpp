@@ -0,0 +1,73 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "epoch.h"
+
+TEST_CASE("epoch_domain: synchronize outlasts readers of the old version", "[epoch]")
+{
+    epoch_domain epochs;
+    std::atomic<const std::vector<int>*> published{new std::vector<int>(64, 0)};
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+
+    // Readers check every version they see is intact; a version freed
+    // early would be caught by the sanitizers or the sum
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                auto guard = epochs.read();
+                const std::vector<int>* v = published.load(std::memory_order_seq_cst);
+                const int first = (*v)[0];
+                for (int x : *v) {
+                    if (x != first) std::abort();
+                }
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    while (reads.load() == 0) std::this_thread::yield();
+    for (int version = 1; version <= 200; ++version) {
+        std::this_thread::yield();
+        auto* next = new std::vector<int>(64, version);
+        const std::vector<int>* old = published.exchange(next, std::memory_order_seq_cst);
+        epochs.synchronize();
+        // Scribble before freeing so a late reader sees a torn version
+        (*const_cast<std::vector<int>*>(old))[0] = -1;
+        delete old;
+    }
+    stop.store(true);
+    for (auto& t : readers) t.join();
+    delete published.load();
+    REQUIRE(reads.load() > 0);
+}
+
+TEST_CASE("epoch_domain: quiescent waits for readers that entered before advance", "[epoch]")
+{
+    epoch_domain epochs;
+    std::atomic<int> step{0};
+
+    // Enters, lets the writer advance, then leaves when told
+    std::thread reader([&] {
+        auto guard = epochs.read();
+        step.store(1);
+        while (step.load() != 2) std::this_thread::yield();
+    });
+    while (step.load() != 1) std::this_thread::yield();
+
+    const uint64_t target = epochs.advance();
+    REQUIRE_FALSE(epochs.quiescent(target));
+    {
+        // A reader entering after advance() does not hold it up
+        auto guard = epochs.read();
+        REQUIRE_FALSE(epochs.quiescent(target));
+    }
+    step.store(2);
+    reader.join();
+    REQUIRE(epochs.quiescent(target));
+}
@@ -9,6 +9,7 @@
 #include <vector>
 #include <string>
 #include <mutex>
+#include <cstdlib>
 
 // 1) Fake parser that hands back a preloaded sequence of orders
 typedef std::lock_guard<std::mutex> lock_t;
@@ -58,14 +59,15 @@ order_t make_order(const char* id,
 // Helper function to run one test sequence
 void run_sequence(const std::vector<order_t>& seq,
                   const std::string&          log_path,
-                  const std::string&          test_name)
+                  const std::string&          test_name,
+                  const exchange_options_t&   options = {})
 {
     using namespace std::chrono_literals;
     std::cout << "\n=== Running " << test_name << " ===\n";
 
     TestParser parser(seq);
     logger     log(log_path);
-    Exchange   exch(&log, &parser);
+    Exchange   exch(&log, &parser, {}, options);
     exch.start();
 
     // Launch 2 client threads to inject orders concurrently
@@ -84,6 +86,20 @@ void run_sequence(const std::vector<order_t>& seq,
     std::this_thread::sleep_for(20ms);
     exch.stop();
 
+    // Every order went through some batch
+    const auto hist = exch.batch_size_histogram();
+    std::cout << "--- Batch sizes ---\n";
+    uint64_t batches = 0;
+    for (size_t i = 0; i < hist.size(); ++i) {
+        if (hist[i] == 0) continue;
+        batches += hist[i];
+        std::cout << ">=" << log2_histogram::bin_floor(i) << ": " << hist[i] << "\n";
+    }
+    if (batches == 0 || batches > seq.size()) {
+        std::cerr << test_name << ": unexpected batch count " << batches << "\n";
+        std::exit(1);
+    }
+
     // Dump the log
     std::ifstream in(log_path);
     if (!in) {
@@ -97,6 +113,254 @@ void run_sequence(const std::vector<order_t>& seq,
     }
 }
 
+// Lines of the log at `path` containing `needle`
+size_t count_lines(const std::string& path, const std::string& needle)
+{
+    std::ifstream in(path);
+    size_t n = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find(needle) != std::string::npos) ++n;
+    }
+    return n;
+}
+
+// Migrates IBM back and forth under a stream of crossing orders; every
+// buy must still meet the sell resting from before the moves.
+void run_migration(const std::string& log_path)
+{
+    using namespace std::chrono_literals;
+    std::cout << "\n=== Running Test #4: IBM migration under load ===\n";
+
+    std::vector<order_t> seq;
+    seq.push_back(make_order("S0", "IBM", order_side::SELL, order_status::NEW, 100, 1000, 0));
+    for (int i = 1; i <= 200; ++i) {
+        const std::string id = "B" + std::to_string(i);
+        seq.push_back(make_order(id.c_str(), "IBM", order_side::BUY, order_status::NEW, 100, 1, i));
+    }
+
+    TestParser parser(seq);
+    logger     log(log_path);
+    exchange_options_t options;
+    options.shards = shard_map(2);
+    options.shards.assign("IBM", 0);
+    Exchange   exch(&log, &parser, {}, options);
+    exch.start();
+
+    std::thread client([&]() {
+        ParsedOrder dummy;
+        while (parser.parse_message(nullptr, 0, dummy)) {
+            exch.on_msg_received(nullptr, 0);
+            std::this_thread::sleep_for(100us);
+        }
+    });
+    uint32_t to = 1;
+    for (int i = 0; i < 6; ++i) {
+        std::this_thread::sleep_for(2ms);
+        if (!exch.migrate("IBM", to)) {
+            std::cerr << "migrate failed\n";
+            std::exit(1);
+        }
+        to ^= 1;
+    }
+    client.join();
+    const uint32_t last = to ^ 1;
+
+    // One trade report per buy, each against the resting sell
+    size_t sell_fills = 0;
+    for (int tries = 0; tries < 500 && sell_fills < 200; ++tries) {
+        std::this_thread::sleep_for(10ms);
+        log.flush();
+        sell_fills = count_lines(log_path, "trade_report");
+    }
+
+    // A single symbol cannot be split, so a rebalance has nothing to move
+    const auto loads = exch.symbol_loads();
+    if (loads.size() != 1 || loads[0].rate != seq.size() || exch.rebalance() != 0) {
+        std::cerr << "unexpected symbol load\n";
+        std::exit(1);
+    }
+    exch.stop();
+
+    if (exch.current_shards().worker_for("IBM") != last) {
+        std::cerr << "shard map did not follow the migration\n";
+        std::exit(1);
+    }
+
+    std::cout << "S0 fill events: " << sell_fills << "\n";
+    if (sell_fills != 200) {
+        std::cerr << "lost fills across migration\n";
+        std::exit(1);
+    }
+}
+
+// Several gateway threads feed symbols, half of them registered in one
+// batch and half never registered, so routes are created and published
+// while other gateways are routing. Every buy crosses a sell of the same
+// size and price.
+void run_gateways(const std::string& log_path)
+{
+    std::cout << "\n=== Running Test #5: concurrent gateways ===\n";
+    const int GATEWAYS = 4, SYMBOLS = 24, PAIRS = 10;
+
+    std::vector<order_t> seq;
+    for (int i = 0; i < PAIRS; ++i) {
+        for (int s = 0; s < SYMBOLS; ++s) {
+            const std::string sym = "G" + std::to_string(s);
+            const std::string sell = "S" + std::to_string(s) + "-" + std::to_string(i);
+            const std::string buy  = "B" + std::to_string(s) + "-" + std::to_string(i);
+            seq.push_back(make_order(sell.c_str(), sym.c_str(), order_side::SELL, order_status::NEW, 100, 1, i));
+            seq.push_back(make_order(buy.c_str(),  sym.c_str(), order_side::BUY,  order_status::NEW, 100, 1, i));
+        }
+    }
+
+    TestParser parser(seq);
+    logger     log(log_path);
+    exchange_options_t options;
+    options.shards = shard_map(4);
+    Exchange   exch(&log, &parser, {}, options);
+    exch.start();
+
+    std::vector<std::pair<std::string, price_band>> batch;
+    for (int s = 0; s < SYMBOLS; s += 2) batch.emplace_back("G" + std::to_string(s), price_band{});
+    batch.emplace_back("G0", price_band{});   // repeats are ignored
+    if (exch.add_symbols(batch) != SYMBOLS / 2 || exch.symbol_loads().size() != SYMBOLS / 2) {
+        std::cerr << "batch registration created the wrong routes\n";
+        std::exit(1);
+    }
+
+    std::vector<std::thread> gateways;
+    for (int g = 0; g < GATEWAYS; ++g) {
+        gateways.emplace_back([&]() {
+            ParsedOrder dummy;
+            while (parser.parse_message(nullptr, 0, dummy)) exch.on_msg_received(nullptr, 0);
+        });
+    }
+    for (auto& th : gateways) th.join();
+
+    // G1 was never registered, but its book is built by now
+    if (exch.add_symbol("G1", price_band{100, 1, 64})) {
+        std::cerr << "a band was accepted after the symbol's first order\n";
+        std::exit(1);
+    }
+
+    // Wait for the workers and the logger to catch up
+    using namespace std::chrono_literals;
+    const size_t expected = size_t(SYMBOLS) * PAIRS;
+    size_t trades = 0;
+    for (int tries = 0; tries < 500 && trades < expected; ++tries) {
+        std::this_thread::sleep_for(10ms);
+        log.flush();
+        trades = count_lines(log_path, "trade_report");
+    }
+    exch.stop();
+
+    const std::vector<symbol_load> loads = exch.symbol_loads();
+    uint64_t applied = 0;
+    for (const symbol_load& l : loads) applied += l.rate;
+    if (loads.size() != SYMBOLS || applied != 2 * expected) {
+        std::cerr << "unexpected routes or order counts\n";
+        std::exit(1);
+    }
+    std::cout << "trades: " << trades << "\n";
+    if (trades != expected) {
+        std::cerr << "lost orders across gateways\n";
+        std::exit(1);
+    }
+}
+
+// Floods one symbol from one gateway with orders that all rest. Under
+// REJECT some may be shed (how many depends on scheduling); every order
+// is either queued or refused with OVERLOADED, and the shard's counters
+// agree. Under BLOCK nothing is refused.
+void run_overload(overload_policy policy, const std::string& log_path)
+{
+    std::cout << "\n=== Running Test #6: overload ("
+              << (policy == overload_policy::REJECT ? "reject" : "block") << ") ===\n";
+    const int ORDERS = 3000;
+
+    std::vector<order_t> seq;
+    for (int i = 0; i < ORDERS; ++i) {
+        const std::string id = "F" + std::to_string(i);
+        seq.push_back(make_order(id.c_str(), "FLD", order_side::BUY, order_status::NEW, 100, 1, i));
+    }
+
+    TestParser parser(seq);
+    logger     log(log_path);
+    exchange_options_t options;
+    options.shards = shard_map(1);
+    options.lane_capacity = 8;
+    options.shard_capacity = 4;
+    options.overload = policy;
+    Exchange   exch(&log, &parser, {}, options);
+    exch.start();
+
+    size_t queued = 0, overloaded = 0;
+    ParsedOrder dummy;
+    while (parser.parse_message(nullptr, 0, dummy)) {
+        const order_result r = exch.on_msg_received(nullptr, 0);
+        if (r == order_result::SUCCESS) ++queued;
+        else if (r == order_result::OVERLOADED) ++overloaded;
+    }
+    exch.stop();
+
+    const shard_stats_t stats = exch.shard_stats().at(0);
+    std::cout << "queued " << queued << ", overloaded " << overloaded
+              << ", depth high water " << stats.depth_high_water << "\n";
+    if (queued + overloaded != ORDERS || stats.rejected != overloaded ||
+        stats.depth_high_water > options.lane_capacity ||
+        (policy == overload_policy::BLOCK && overloaded != 0)) {
+        std::cerr << "overload accounting is off\n";
+        std::exit(1);
+    }
+}
+
+// Symbols and orders that arrive before start() wait for it; an
+// exchange that is never started still shuts down cleanly.
+void run_lifecycle(const std::string& log_path)
+{
+    using namespace std::chrono_literals;
+    std::cout << "\n=== Running Test #8: orders before start() ===\n";
+
+    std::vector<order_t> seq = {
+        make_order("S1", "LIFE", order_side::SELL, order_status::NEW, 100, 5, 1),
+        make_order("B1", "LIFE", order_side::BUY,  order_status::NEW, 100, 5, 2),
+    };
+    TestParser parser(seq);
+    logger     log(log_path);
+    {
+        Exchange never_started(&log, &parser);
+        never_started.add_symbol("IDLE");
+    }
+
+    Exchange exch(&log, &parser);
+    if (!exch.add_symbol("LIFE") || exch.add_symbol("LIFE", price_band{1, 1, 64})) {
+        std::cerr << "a symbol's band was registered twice\n";
+        std::exit(1);
+    }
+    ParsedOrder dummy;
+    while (parser.parse_message(nullptr, 0, dummy)) {
+        if (exch.on_msg_received(nullptr, 0) != order_result::SUCCESS) {
+            std::cerr << "order refused before start()\n";
+            std::exit(1);
+        }
+    }
+    exch.start();
+
+    size_t trades = 0;
+    for (int tries = 0; tries < 500 && trades < 1; ++tries) {
+        std::this_thread::sleep_for(10ms);
+        log.flush();
+        trades = count_lines(log_path, "trade_report");
+    }
+    exch.stop();
+
+    if (trades != 1) {
+        std::cerr << "orders sent before start() were not applied\n";
+        std::exit(1);
+    }
+}
+
 int main() {
     using namespace std::chrono_literals;
 
@@ -111,7 +375,9 @@ int main() {
         make_order("S2","AAPL",order_side::SELL,order_status::NEW,             55, 5,  7),
         make_order("B4","AAPL",order_side::BUY, order_status::PARTIALLY_FILLED,55, 4,  8),
     };
-    run_sequence(seq1, "test1.log", "Test #1: AAPL matching + cancels");
+    exchange_options_t spin;
+    spin.wait = wait_policy::SPIN;
+    run_sequence(seq1, "test1.log", "Test #1: AAPL matching + cancels", spin);
 
     // Test 2: large buy vs multiple smaller sells (partial fills)
     std::vector<order_t> seq2 = {
@@ -120,7 +386,9 @@ int main() {
         make_order("S11","GOOG",order_side::SELL,order_status::NEW, 1000,15, 3),
         make_order("S12","GOOG",order_side::SELL,order_status::NEW, 1000,10, 4),  // leaves unfilled residue
     };
-    run_sequence(seq2, "test2.log", "Test #2: GOOG partial‐fill cascade");
+    exchange_options_t yield;
+    yield.wait = wait_policy::SPIN_YIELD;
+    run_sequence(seq2, "test2.log", "Test #2: GOOG partial‐fill cascade", yield);
 
     // Test 3: orders on different tickers interleaved (no cross‐matching)
     std::vector<order_t> seq3 = {
@@ -129,7 +397,28 @@ int main() {
         make_order("S21","MSFT",order_side::SELL,order_status::NEW,200, 10, 3),
         make_order("B21","AAPL",order_side::BUY, order_status::NEW,150,  5, 4),
     };
-    run_sequence(seq3, "test3.log", "Test #3: Mixed‐ticker isolation");
+    // Parked, pinned workers and logger (CPU 0 always exists); the two
+    // tickers on separate workers
+    exchange_options_t pinned;
+    pinned.shards = shard_map(2);
+    pinned.shards.assign("AAPL", 0);
+    pinned.shards.assign("MSFT", 1);
+    pinned.placement.worker_cpu = { {"0", 0}, {"1", 0} };
+    pinned.placement.logger_cpu = 0;
+    run_sequence(seq3, "test3.log", "Test #3: Mixed‐ticker isolation", pinned);
+
+    // Test 4: move a book between workers while its orders keep arriving
+    run_migration("test4.log");
+
+    // Test 5: routes registered while several gateways route
+    run_gateways("test5.log");
+
+    // Test 6: a full shard sheds or blocks
+    run_overload(overload_policy::REJECT, "test6.log");
+    run_overload(overload_policy::BLOCK, "test7.log");
+
+    // Test 8: registration and orders before start()
+    run_lifecycle("test8.log");
 
     return 0;
 }
\ No newline at end of file
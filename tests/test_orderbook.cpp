@@ -4,9 +4,12 @@
 #include <chrono>
 #include <thread>
 #include <random>
+#include <fstream>
+#include <sstream>
 #include "logger.h"
 #include "types.h"
 #include "orderbook.h"
+#include "orderbook_impl.h"
 
 /*
   Global logger pointer used across tests.
@@ -41,7 +44,8 @@ order_t make_order(
     order_status status,
     uint32_t price,
     size_t qty,
-    bool post_only
+    bool post_only,
+    order_tif tif = order_tif::GTC
 )
 {
     return order_t(
@@ -53,7 +57,8 @@ order_t make_order(
         status,
         price,
         qty,
-        post_only
+        post_only,
+        tif
     );
 }
 
@@ -193,14 +198,15 @@ TEST_CASE("Orderbook: add() invalid side", "[orderbook][add]")
 
 TEST_CASE("Orderbook: add() invalid price", "[orderbook][add]")
 {
-    orderbook ob(g_test_logger);
+    // Five-cent ticks from 10000: prices must be 10000 + 5k
+    orderbook ob(g_test_logger, price_band{10000, 5, 2000});
 
     char TICKER_ABC[4] = { 'A','B','C',' ' };
     char ID[16] = {
         'I','N','V','P','R','I','C','E','0','0','0','0','0','0','0','1'
     };
 
-    // Price > MAX_PRICE (which is 20000)
+    // Off the tick grid
     order_t invalid_price_order = make_order(
         get_current_time_ns(),
         ID,
@@ -208,11 +214,15 @@ TEST_CASE("Orderbook: add() invalid price", "[orderbook][add]")
         order_kind::LMT,
         order_side::BUY,
         order_status::NEW,
-        30000,  // invalid
+        30003,  // invalid
         10,
         false
     );
     REQUIRE(ob.add(invalid_price_order) == order_result::INVALID_PRICE);
+
+    // Prices the ladders reserve as "no level" are never valid
+    invalid_price_order.price = UINT32_MAX;
+    REQUIRE(ob.add(invalid_price_order) == order_result::INVALID_PRICE);
 }
 
 TEST_CASE("Orderbook: cancel() basic", "[orderbook][cancel]")
@@ -240,7 +250,7 @@ TEST_CASE("Orderbook: cancel() basic", "[orderbook][cancel]")
     auto key1 = make_key(ID1);
     REQUIRE(ob.contains(key1) == true);
 
-    REQUIRE(ob.cancel(key1) == order_result::SUCCESS);
+    REQUIRE(ob.cancel(key1, 0) == order_result::SUCCESS);
     REQUIRE(ob.contains(key1) == false);
 
     // best_ask should now be empty
@@ -259,7 +269,7 @@ TEST_CASE("Orderbook: cancel() order not found", "[orderbook][cancel]")
     auto key = make_key(ID);
 
     // Canceling a non-existent order should fail
-    REQUIRE(ob.cancel(key) == order_result::ORDER_NOT_FOUND);
+    REQUIRE(ob.cancel(key, 0) == order_result::ORDER_NOT_FOUND);
 }
 
 TEST_CASE("Orderbook: modify() same price", "[orderbook][modify]")
@@ -432,8 +442,8 @@ TEST_CASE("Orderbook: execute() multiple matches", "[orderbook][execute]")
         - 2 BUY orders:  (price=100, qty=5),  (price=95, qty=10)
         - 2 SELL orders: (price=90,  qty=6),  (price=85, qty=10)
 
-      best_bid=100, best_ask=85 => everything will keep matching until
-      no more cross can occur.
+      Orders match on arrival, so each SELL sweeps the resting BUYs
+      best price first until it is filled or no longer crosses.
     */
     orderbook ob(g_test_logger);
 
@@ -482,6 +492,12 @@ TEST_CASE("Orderbook: execute() multiple matches", "[orderbook][execute]")
     );
     REQUIRE(ob.add(s1) == order_result::SUCCESS);
 
+    // s1(90@6) filled against b1(100@5) then 1 from b2 => b2 has 9 left
+    REQUIRE_FALSE(ob.contains(make_key(IDB1)));
+    REQUIRE_FALSE(ob.contains(make_key(IDS1)));
+    REQUIRE(ob.best_bid().value() == 95);
+    REQUIRE_FALSE(ob.best_ask().has_value());
+
     // SELL #2
     char IDS2[16] = { 'M','U','L','T','I','-','S','E','L','L','-','0','0','0','0','2' };
     auto s2 = make_order(
@@ -497,23 +513,10 @@ TEST_CASE("Orderbook: execute() multiple matches", "[orderbook][execute]")
     );
     REQUIRE(ob.add(s2) == order_result::SUCCESS);
 
-    // Confirm best_bid=100, best_ask=85
-    REQUIRE(ob.best_bid().has_value());
-    REQUIRE(ob.best_bid().value() == 100);
-
-    REQUIRE(ob.best_ask().has_value());
-    REQUIRE(ob.best_ask().value() == 85);
-
-    // Execute all matches
+    // Nothing is left crossed, so execute() has no work to do
     ob.execute();
 
-    // After execution:
-    //  - b1(100@5), b2(95@10), s2(85@10), s1(90@6)
-    //
-    //   b1 -> fully fills vs s2 partial => leftover s2=5
-    //   b2 -> partial fill with remaining s2 => leftover b2=5, s2 fully filled
-    //   b2 -> then tries s1 => leftover s1=1, b2 fully filled
-    //   => b1 gone, b2 gone, s2 gone, s1 remains with qty=1
+    // s2(85@10) filled the remaining b2(95@9) => s2 rests with qty=1
 
     auto kb1  = make_key(IDB1);
     auto kb2  = make_key(IDB2);
@@ -522,12 +525,12 @@ TEST_CASE("Orderbook: execute() multiple matches", "[orderbook][execute]")
 
     REQUIRE_FALSE(ob.contains(kb1)); // fully executed
     REQUIRE_FALSE(ob.contains(kb2)); // fully executed
-    REQUIRE_FALSE(ob.contains(ks2)); // fully executed
-    REQUIRE(ob.contains(ks1));       // partial fill => remains
+    REQUIRE_FALSE(ob.contains(ks1)); // fully executed
+    REQUIRE(ob.contains(ks2));       // partial fill => remains
 
-    // best_ask should now be 90 (from s1 leftover)
+    // best_ask should now be 85 (from s2 leftover)
     REQUIRE(ob.best_ask().has_value());
-    REQUIRE(ob.best_ask().value() == 90);
+    REQUIRE(ob.best_ask().value() == 85);
 
     // best_bid should not exist (no more buys)
     REQUIRE_FALSE(ob.best_bid().has_value());
@@ -561,7 +564,7 @@ TEST_CASE("Orderbook: empty best_bid / best_ask", "[orderbook]")
 
     // Cancel the BUY
     auto kb = make_key(ID_B);
-    REQUIRE(ob.cancel(kb) == order_result::SUCCESS);
+    REQUIRE(ob.cancel(kb, 0) == order_result::SUCCESS);
 
     REQUIRE_FALSE(ob.best_bid().has_value());
     REQUIRE_FALSE(ob.best_ask().has_value());
@@ -572,8 +575,9 @@ TEST_CASE("Orderbook: boundary test at max price", "[orderbook][boundary]")
     orderbook ob(g_test_logger);
 
     /*
-      Since MAX_PRICE = 20000, let's place a BUY or SELL exactly at 20000
-      and confirm it succeeds. Then see if a SELL with price=20001 fails.
+      The default band covers 0..MAX_PRICE (20000). Place a BUY exactly at
+      20000, then a SELL at 20001, which is outside the band and must rest
+      in the overflow levels rather than be rejected.
     */
 
     char ID_BMax[16] = { 'B','M','A','X','P','R','I','C','E','0','0','0','0','0','0','B' };
@@ -593,7 +597,7 @@ TEST_CASE("Orderbook: boundary test at max price", "[orderbook][boundary]")
     );
     REQUIRE(ob.add(bmax) == order_result::SUCCESS);
 
-    // Attempt SELL at price=20001 (invalid)
+    // SELL just above the band
     order_t sinv = make_order(
         get_current_time_ns(),
         ID_SInv,
@@ -601,11 +605,13 @@ TEST_CASE("Orderbook: boundary test at max price", "[orderbook][boundary]")
         order_kind::LMT,
         order_side::SELL,
         order_status::NEW,
-        20001,  // invalid
+        20001,  // outside the band
         5,
         false
     );
-    REQUIRE(ob.add(sinv) == order_result::INVALID_PRICE);
+    REQUIRE(ob.add(sinv) == order_result::SUCCESS);
+    REQUIRE(ob.best_bid().value() == 20000);
+    REQUIRE(ob.best_ask().value() == 20001);
 }
 
 
@@ -729,7 +735,7 @@ TEST_CASE("Orderbook: multi-level scenario", "[orderbook][multi-level]")
 
     // Now cancel the BUY@100
     auto kb1 = make_key(BID1);
-    REQUIRE(ob.cancel(kb1) == order_result::SUCCESS);
+    REQUIRE(ob.cancel(kb1, 0) == order_result::SUCCESS);
 
     // best_bid should now be 98
     bb = ob.best_bid();
@@ -738,7 +744,7 @@ TEST_CASE("Orderbook: multi-level scenario", "[orderbook][multi-level]")
 
     // Cancel SELL@105
     auto ks1 = make_key(SID1);
-    REQUIRE(ob.cancel(ks1) == order_result::SUCCESS);
+    REQUIRE(ob.cancel(ks1, 0) == order_result::SUCCESS);
 
     // best_ask should now be 107
     ba = ob.best_ask();
@@ -852,7 +858,7 @@ TEST_CASE("Orderbook: partial match + mid-sequence cancel", "[orderbook][partial
     REQUIRE(ba.value() == 95);
 
     // Let's cancel the SELL leftover
-    REQUIRE(ob.cancel(ks) == order_result::SUCCESS);
+    REQUIRE(ob.cancel(ks, 0) == order_result::SUCCESS);
     REQUIRE_FALSE(ob.contains(ks));
     REQUIRE_FALSE(ob.best_ask().has_value());
 }
@@ -918,7 +924,7 @@ TEST_CASE("Orderbook: bulk random stress test", "[orderbook][stress]")
 
             // If it exists, cancel it
             if(ob.contains(key)) {
-                ob.cancel(key);
+                ob.cancel(key, 0);
             }
             // Mark as canceled
             active_ids[idx].clear();
@@ -953,3 +959,958 @@ TEST_CASE("Orderbook: bulk random stress test", "[orderbook][stress]")
         REQUIRE(ba.value() <= 20000);
     }
 }
+
+/**
+ * Best bid/ask must move across wide gaps of empty levels when the
+ * best level empties, including levels at both ends of the price range.
+ */
+TEST_CASE("Orderbook: best price across sparse levels", "[orderbook][ladder]")
+{
+    orderbook ob(g_test_logger);
+
+    char IDB_TOP[16] = { 'S','P','A','R','S','E','-','B','I','D','-','T','O','P','0','1' };
+    char IDB_LOW[16] = { 'S','P','A','R','S','E','-','B','I','D','-','L','O','W','0','1' };
+    char IDA_LOW[16] = { 'S','P','A','R','S','E','-','A','S','K','-','L','O','W','0','1' };
+    char IDA_TOP[16] = { 'S','P','A','R','S','E','-','A','S','K','-','T','O','P','0','1' };
+
+    REQUIRE(ob.add(make_order(get_current_time_ns(), IDB_TOP, "SPRS", order_kind::LMT,
+        order_side::BUY, order_status::NEW, 9000, 10, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(get_current_time_ns(), IDB_LOW, "SPRS", order_kind::LMT,
+        order_side::BUY, order_status::NEW, 0, 10, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(get_current_time_ns(), IDA_LOW, "SPRS", order_kind::LMT,
+        order_side::SELL, order_status::NEW, 9500, 10, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(get_current_time_ns(), IDA_TOP, "SPRS", order_kind::LMT,
+        order_side::SELL, order_status::NEW, MAX_PRICE, 10, false)) == order_result::SUCCESS);
+
+    REQUIRE(ob.best_bid().value() == 9000);
+    REQUIRE(ob.best_ask().value() == 9500);
+
+    REQUIRE(ob.cancel(make_key(IDB_TOP), 0) == order_result::SUCCESS);
+    REQUIRE(ob.cancel(make_key(IDA_LOW), 0) == order_result::SUCCESS);
+    REQUIRE(ob.best_bid().value() == 0);
+    REQUIRE(ob.best_ask().value() == MAX_PRICE);
+
+    REQUIRE(ob.cancel(make_key(IDB_LOW), 0) == order_result::SUCCESS);
+    REQUIRE(ob.cancel(make_key(IDA_TOP), 0) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.best_bid().has_value());
+    REQUIRE_FALSE(ob.best_ask().has_value());
+}
+
+/**
+ * The occupancy bitmap must agree with a brute-force scan for the
+ * best/next-level queries the ladders rely on.
+ */
+TEST_CASE("occupancy_bitmap: queries match linear scan", "[bitmap]")
+{
+    constexpr uint32_t SLOTS = MAX_PRICE + 1;
+    occupancy_bitmap bm(SLOTS);
+    std::vector<bool> ref(SLOTS, false);
+
+    REQUIRE(bm.empty());
+    REQUIRE(bm.highest() == occupancy_bitmap::NONE);
+    REQUIRE(bm.lowest() == occupancy_bitmap::NONE);
+
+    std::mt19937 rng(424242);
+    std::uniform_int_distribution<uint32_t> slot_dist(0, SLOTS - 1);
+
+    auto scan_below = [&](uint32_t i) {
+        for (uint32_t j = i; j-- > 0;) if (ref[j]) return j;
+        return occupancy_bitmap::NONE;
+    };
+    auto scan_above = [&](uint32_t i) {
+        for (uint32_t j = i + 1; j < SLOTS; ++j) if (ref[j]) return j;
+        return occupancy_bitmap::NONE;
+    };
+
+    for (int step = 0; step < 4000; ++step) {
+        uint32_t s = slot_dist(rng);
+        if (step % 3 == 0 && ref[s]) { bm.clear(s); ref[s] = false; }
+        else                         { bm.set(s);   ref[s] = true;  }
+
+        uint32_t q = slot_dist(rng);
+        REQUIRE(bm.test(q) == ref[q]);
+        REQUIRE(bm.next_below(q) == scan_below(q));
+        REQUIRE(bm.next_above(q) == scan_above(q));
+    }
+
+    REQUIRE(bm.highest() == scan_below(SLOTS));
+    REQUIRE(bm.lowest() == (ref[0] ? 0 : scan_above(0)));
+
+    for (uint32_t s = 0; s < SLOTS; ++s) if (ref[s]) bm.clear(s);
+    REQUIRE(bm.empty());
+}
+
+/**
+ * Orders at one price must fill oldest-first even after a cancel frees
+ * a slot ahead of older orders in the level.
+ */
+TEST_CASE("Orderbook: FIFO time priority after cancel", "[orderbook][fifo]")
+{
+    orderbook ob(g_test_logger);
+
+    char IDA[16] = { 'F','I','F','O','-','B','U','Y','-','A','0','0','0','0','0','1' };
+    char IDB[16] = { 'F','I','F','O','-','B','U','Y','-','B','0','0','0','0','0','1' };
+    char IDC[16] = { 'F','I','F','O','-','B','U','Y','-','C','0','0','0','0','0','1' };
+    char IDS[16] = { 'F','I','F','O','-','S','E','L','L','0','0','0','0','0','0','1' };
+
+    REQUIRE(ob.add(make_order(1, IDA, "FIFO", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(2, IDB, "FIFO", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false)) == order_result::SUCCESS);
+    REQUIRE(ob.cancel(make_key(IDA), 0) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(3, IDC, "FIFO", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false)) == order_result::SUCCESS);
+
+    // Sell exactly B's size: B arrived before C, so B must fill
+    REQUIRE(ob.add(make_order(4, IDS, "FIFO", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 100, 10, false)) == order_result::SUCCESS);
+    ob.execute();
+
+    REQUIRE_FALSE(ob.contains(make_key(IDB)));
+    REQUIRE(ob.contains(make_key(IDC)));
+    REQUIRE_FALSE(ob.contains(make_key(IDS)));
+    REQUIRE(ob.best_bid().value() == 100);
+    REQUIRE_FALSE(ob.best_ask().has_value());
+}
+
+/**
+ * Repricing a resting order through the spread must trade immediately
+ * and rest only what is left.
+ */
+TEST_CASE("Orderbook: modify() crosses on reprice", "[orderbook][modify][match]")
+{
+    orderbook ob(g_test_logger);
+
+    char IDB[16] = { 'R','E','P','R','I','C','E','-','B','U','Y','0','0','0','0','1' };
+    char IDS[16] = { 'R','E','P','R','I','C','E','-','S','E','L','L','0','0','0','1' };
+
+    auto b = make_order(1, IDB, "RPRC", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false);
+    REQUIRE(ob.add(b) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(2, IDS, "RPRC", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 105, 4, false)) == order_result::SUCCESS);
+
+    auto b2 = b;
+    b2.price = 105;
+    b2.timestamp = 3;
+    REQUIRE(ob.modify(make_key(IDB), b2) == order_result::SUCCESS);
+
+    REQUIRE_FALSE(ob.contains(make_key(IDS)));
+    REQUIRE(ob.contains(make_key(IDB)));
+    REQUIRE(ob.best_bid().value() == 105);
+    REQUIRE_FALSE(ob.best_ask().has_value());
+
+    // The remaining 6 can still be cancelled by ID
+    REQUIRE(ob.cancel(make_key(IDB), 0) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.best_bid().has_value());
+}
+
+/**
+ * A reprice reports its trades under the resting order's ID, whatever
+ * ID the modify request carries; a modify to size 0 is a cancel.
+ */
+TEST_CASE("Orderbook: modify() reports by the resting order's ID", "[orderbook][modify]")
+{
+    std::vector<log_event_t> events;
+    basic_orderbook<callback_sink> ob(callback_sink([&](const log_event_t& ev) { events.push_back(ev); }));
+
+    char IDB[16] = { 'M','O','D','-','R','E','S','T','-','B','U','Y','0','0','0','1' };
+    char IDS[16] = { 'M','O','D','-','R','E','S','T','-','S','E','L','L','0','0','1' };
+    char IDX[16] = { 'M','O','D','-','R','E','Q','U','E','S','T','-','0','0','0','1' };
+
+    auto b = make_order(1, IDB, "MODR", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false);
+    REQUIRE(ob.add(b) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(2, IDS, "MODR", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 105, 4, false)) == order_result::SUCCESS);
+
+    auto b2 = make_order(3, IDX, "MODR", order_kind::LMT, order_side::BUY,
+        order_status::PARTIALLY_FILLED, 105, 10, false);
+    events.clear();
+    REQUIRE(ob.modify(make_key(IDB), b2) == order_result::SUCCESS);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[1].kind == log_event_kind::TRADE_REPORT);
+    REQUIRE(events[1].id == make_key(IDB));
+    REQUIRE(events[1].id_secondary == make_key(IDS));
+    REQUIRE(ob.resting_order(make_key(IDB)).has_value());
+    REQUIRE(make_key(ob.resting_order(make_key(IDB))->order_id) == make_key(IDB));
+
+    auto zero = b;
+    zero.qty = 0;
+    zero.timestamp = 4;
+    events.clear();
+    REQUIRE(ob.modify(make_key(IDB), zero) == order_result::SUCCESS);
+    REQUIRE(events.size() == 1);
+    REQUIRE(events[0].kind == log_event_kind::CANCEL);
+    REQUIRE(events[0].timestamp == 4);
+    REQUIRE(events[0].qty == 6);
+    REQUIRE_FALSE(ob.contains(make_key(IDB)));
+    REQUIRE(ob.ids().size() == 0);
+}
+
+/**
+ * A market order sweeps the opposite side level by level, ignores its
+ * own price field, and never rests any unfilled remainder.
+ */
+TEST_CASE("Orderbook: market order multi-level sweep", "[orderbook][market]")
+{
+    orderbook ob(g_test_logger);
+
+    char IDS1[16] = { 'M','K','T','-','A','S','K','-','1','0','1','0','0','0','0','1' };
+    char IDS2[16] = { 'M','K','T','-','A','S','K','-','1','0','2','0','0','0','0','1' };
+    char IDS3[16] = { 'M','K','T','-','A','S','K','-','1','0','5','0','0','0','0','1' };
+    char IDM1[16] = { 'M','K','T','-','B','U','Y','-','0','0','0','0','0','0','0','1' };
+    char IDM2[16] = { 'M','K','T','-','B','U','Y','-','0','0','0','0','0','0','0','2' };
+    char IDM3[16] = { 'M','K','T','-','S','E','L','L','0','0','0','0','0','0','0','1' };
+
+    REQUIRE(ob.add(make_order(1, IDS1, "MKTS", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 101, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(2, IDS2, "MKTS", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 102, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(3, IDS3, "MKTS", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 105, 5, false)) == order_result::SUCCESS);
+
+    // Sweeps 101 and 102 completely and takes 2 of 5 at 105
+    REQUIRE(ob.add(make_order(4, IDM1, "MKTS", order_kind::MKT, order_side::BUY,
+        order_status::NEW, 0, 12, false)) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.contains(make_key(IDS1)));
+    REQUIRE_FALSE(ob.contains(make_key(IDS2)));
+    REQUIRE(ob.contains(make_key(IDS3)));
+    REQUIRE_FALSE(ob.contains(make_key(IDM1)));
+    REQUIRE(ob.best_ask().value() == 105);
+
+    // Larger than the book: fills the last 3 and drops the rest
+    REQUIRE(ob.add(make_order(5, IDM2, "MKTS", order_kind::MKT, order_side::BUY,
+        order_status::NEW, 0, 100, false)) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.best_ask().has_value());
+    REQUIRE_FALSE(ob.best_bid().has_value());
+    REQUIRE_FALSE(ob.contains(make_key(IDM2)));
+
+    // Nothing to trade against
+    REQUIRE(ob.add(make_order(6, IDM3, "MKTS", order_kind::MKT, order_side::SELL,
+        order_status::NEW, 0, 10, false)) == order_result::NO_MATCH);
+    REQUIRE_FALSE(ob.best_bid().has_value());
+    REQUIRE_FALSE(ob.best_ask().has_value());
+}
+
+/**
+ * Post-only orders are rejected instead of taking liquidity, and
+ * IOC/FOK orders trade immediately without ever resting.
+ */
+TEST_CASE("Orderbook: post-only, IOC and FOK", "[orderbook][tif]")
+{
+    orderbook ob(g_test_logger);
+
+    char IDS1[16] = { 'T','I','F','-','A','S','K','-','1','0','1','0','0','0','0','1' };
+    char IDS2[16] = { 'T','I','F','-','A','S','K','-','1','0','3','0','0','0','0','1' };
+    char IDP1[16] = { 'T','I','F','-','P','O','S','T','-','0','0','0','0','0','0','1' };
+    char IDP2[16] = { 'T','I','F','-','P','O','S','T','-','0','0','0','0','0','0','2' };
+    char IDI1[16] = { 'T','I','F','-','I','O','C','-','0','0','0','0','0','0','0','1' };
+    char IDF1[16] = { 'T','I','F','-','F','O','K','-','0','0','0','0','0','0','0','1' };
+    char IDF2[16] = { 'T','I','F','-','F','O','K','-','0','0','0','0','0','0','0','2' };
+
+    REQUIRE(ob.add(make_order(1, IDS1, "TIFS", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 101, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(2, IDS2, "TIFS", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 103, 5, false)) == order_result::SUCCESS);
+
+    SECTION("post-only") {
+        // Crossing post-only is rejected and leaves the book unchanged
+        REQUIRE(ob.add(make_order(3, IDP1, "TIFS", order_kind::LMT, order_side::BUY,
+            order_status::NEW, 101, 5, true)) == order_result::WOULD_CROSS);
+        REQUIRE_FALSE(ob.contains(make_key(IDP1)));
+        REQUIRE(ob.best_ask().value() == 101);
+
+        // Passive post-only rests normally
+        auto p2 = make_order(4, IDP2, "TIFS", order_kind::LMT, order_side::BUY,
+            order_status::NEW, 100, 5, true);
+        REQUIRE(ob.add(p2) == order_result::SUCCESS);
+        REQUIRE(ob.best_bid().value() == 100);
+
+        // Repricing it through the spread is rejected; original stays
+        p2.price = 102;
+        REQUIRE(ob.modify(make_key(IDP2), p2) == order_result::WOULD_CROSS);
+        REQUIRE(ob.best_bid().value() == 100);
+        REQUIRE(ob.best_ask().value() == 101);
+    }
+
+    SECTION("IOC") {
+        // Takes 101 only (limit 102), drops the remaining 5
+        REQUIRE(ob.add(make_order(3, IDI1, "TIFS", order_kind::LMT, order_side::BUY,
+            order_status::NEW, 102, 10, false, order_tif::IOC)) == order_result::SUCCESS);
+        REQUIRE_FALSE(ob.contains(make_key(IDI1)));
+        REQUIRE_FALSE(ob.contains(make_key(IDS1)));
+        REQUIRE_FALSE(ob.best_bid().has_value());
+        REQUIRE(ob.best_ask().value() == 103);
+    }
+
+    SECTION("FOK") {
+        // 10 needed but only 5 reachable at <= 102: rejected, book untouched
+        REQUIRE(ob.add(make_order(3, IDF1, "TIFS", order_kind::LMT, order_side::BUY,
+            order_status::NEW, 102, 10, false, order_tif::FOK)) == order_result::INSUFFICIENT_LIQUIDITY);
+        REQUIRE(ob.contains(make_key(IDS1)));
+        REQUIRE(ob.best_ask().value() == 101);
+
+        // At 103 both levels are reachable: filled in full
+        REQUIRE(ob.add(make_order(4, IDF2, "TIFS", order_kind::LMT, order_side::BUY,
+            order_status::NEW, 103, 10, false, order_tif::FOK)) == order_result::SUCCESS);
+        REQUIRE_FALSE(ob.contains(make_key(IDF2)));
+        REQUIRE_FALSE(ob.best_ask().has_value());
+        REQUIRE_FALSE(ob.best_bid().has_value());
+    }
+}
+
+/**
+ * Immediate-only orders are reported by external ID and never interned,
+ * even while a sink is listening.
+ */
+TEST_CASE("Orderbook: immediate-only orders stay out of the ID lookup", "[orderbook][tif]")
+{
+    std::vector<log_event_t> events;
+    basic_orderbook<callback_sink> ob(callback_sink([&](const log_event_t& ev) { events.push_back(ev); }));
+
+    char IDS1[16] = { 'T','A','K','E','R','-','A','S','K','-','0','0','0','0','0','1' };
+    char IDI1[16] = { 'T','A','K','E','R','-','I','O','C','-','0','0','0','0','0','1' };
+    char IDM1[16] = { 'T','A','K','E','R','-','M','K','T','-','0','0','0','0','0','1' };
+
+    REQUIRE(ob.add(make_order(1, IDS1, "TAKE", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 101, 8, false)) == order_result::SUCCESS);
+
+    // IOC takes 8 and cancels the other 2
+    events.clear();
+    REQUIRE(ob.add(make_order(2, IDI1, "TAKE", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 101, 10, false, order_tif::IOC)) == order_result::SUCCESS);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].kind == log_event_kind::TRADE_REPORT);
+    REQUIRE(events[0].id == make_key(IDI1));
+    REQUIRE(events[0].id_secondary == make_key(IDS1));
+    REQUIRE(events[1].kind == log_event_kind::CANCEL);
+    REQUIRE(events[1].id == make_key(IDI1));
+    REQUIRE(events[1].qty == 2);
+
+    // A market sell against an empty bid side cancels in full
+    events.clear();
+    REQUIRE(ob.add(make_order(3, IDM1, "TAKE", order_kind::MKT, order_side::SELL,
+        order_status::NEW, 0, 4, false)) == order_result::NO_MATCH);
+    REQUIRE(events.size() == 1);
+    REQUIRE(events[0].id == make_key(IDM1));
+
+    REQUIRE_FALSE(ob.contains(make_key(IDI1)));
+    REQUIRE_FALSE(ob.contains(make_key(IDM1)));
+    REQUIRE(ob.ids().size() == 0);
+}
+
+/**
+ * Reducing an order's size at the same price keeps its queue position;
+ * increasing it sends the order to the back of the level.
+ */
+TEST_CASE("Orderbook: modify() size reduction keeps priority", "[orderbook][modify][fifo]")
+{
+    orderbook ob(g_test_logger);
+
+    char IDA[16] = { 'R','E','D','U','C','E','-','B','U','Y','-','A','0','0','0','1' };
+    char IDB[16] = { 'R','E','D','U','C','E','-','B','U','Y','-','B','0','0','0','1' };
+    char IDS[16] = { 'R','E','D','U','C','E','-','S','E','L','L','0','0','0','0','1' };
+    char IDT[16] = { 'R','E','D','U','C','E','-','S','E','L','L','0','0','0','0','2' };
+
+    auto a = make_order(1, IDA, "REDU", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false);
+    REQUIRE(ob.add(a) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(2, IDB, "REDU", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false)) == order_result::SUCCESS);
+
+    // A shrinks 10 -> 4 and stays ahead of B
+    a.qty = 4;
+    a.timestamp = 3;
+    REQUIRE(ob.modify(make_key(IDA), a) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(4, IDS, "REDU", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 100, 4, false)) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.contains(make_key(IDA)));
+    REQUIRE(ob.contains(make_key(IDB)));
+
+    // B grows 10 -> 12 (back of the queue, alone at 100) and still fills
+    auto b = make_order(5, IDB, "REDU", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 12, false);
+    REQUIRE(ob.modify(make_key(IDB), b) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(6, IDT, "REDU", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 100, 12, false)) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.contains(make_key(IDB)));
+    REQUIRE_FALSE(ob.best_bid().has_value());
+    REQUIRE_FALSE(ob.best_ask().has_value());
+}
+
+/**
+ * The word-wise key compare and hash must see every one of the 16 bytes,
+ * including the trailing byte the client leaves as padding.
+ */
+TEST_CASE("order_id_key: word-wise equality and hash", "[orderbook][hash]")
+{
+    char A[16] = { 'H','A','S','H','-','K','E','Y','-','0','0','0','0','0','0','1' };
+    order_id_key ka = make_key(A);
+    order_id_hasher h;
+
+    for (int i = 0; i < 16; ++i) {
+        order_id_key kb = ka;
+        kb.order_id[i] ^= 1;
+        REQUIRE_FALSE(ka == kb);
+        REQUIRE(h(ka) != h(kb));
+    }
+
+    order_id_key copy = make_key(A);
+    REQUIRE(ka == copy);
+    REQUIRE(h(ka) == h(copy));
+}
+
+/**
+ * A done order's ID leaves the index, whether it was cancelled or filled,
+ * so the same ID can be sent again; a cancel or modify of a done ID finds
+ * nothing.
+ */
+TEST_CASE("Orderbook: IDs are forgotten once orders are done", "[orderbook][index]")
+{
+    basic_orderbook<callback_sink> ob(callback_sink([](const log_event_t&) {}));
+
+    char A[16] = { 'F','O','R','G','E','T','-','A','0','0','0','0','0','0','0','1' };
+    char B[16] = { 'F','O','R','G','E','T','-','B','0','0','0','0','0','0','0','1' };
+    char S[16] = { 'F','O','R','G','E','T','-','S','0','0','0','0','0','0','0','1' };
+
+    REQUIRE(ob.add(make_order(1, A, "FRGT", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false)) == order_result::SUCCESS);
+    REQUIRE(ob.ids().size() == 1);
+    // Same ID again while resting is a duplicate
+    REQUIRE(ob.add(make_order(2, A, "FRGT", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false)) == order_result::DUPLICATE_ID);
+
+    REQUIRE(ob.cancel(make_key(A), 0) == order_result::SUCCESS);
+    REQUIRE(ob.ids().size() == 0);
+    REQUIRE_FALSE(ob.contains(make_key(A)));
+    REQUIRE(ob.cancel(make_key(A), 0) == order_result::ORDER_NOT_FOUND);
+    auto repriced = make_order(3, A, "FRGT", order_kind::LMT, order_side::BUY,
+        order_status::PARTIALLY_FILLED, 99, 10, false);
+    REQUIRE(ob.modify(make_key(A), repriced) == order_result::ORDER_NOT_FOUND);
+
+    // A repriced order keeps its ID; a filled one frees it
+    REQUIRE(ob.add(make_order(4, B, "FRGT", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false)) == order_result::SUCCESS);
+    auto moved = make_order(5, B, "FRGT", order_kind::LMT, order_side::BUY,
+        order_status::PARTIALLY_FILLED, 101, 10, false);
+    REQUIRE(ob.modify(make_key(B), moved) == order_result::SUCCESS);
+    REQUIRE(ob.contains(make_key(B)));
+    REQUIRE(ob.resting_order(make_key(B))->price == 101);
+    REQUIRE(ob.add(make_order(6, S, "FRGT", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 101, 10, false)) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.contains(make_key(B)));
+    REQUIRE_FALSE(ob.contains(make_key(S)));
+    REQUIRE(ob.ids().size() == 0);
+
+    // The ID can rest again
+    REQUIRE(ob.add(make_order(7, A, "FRGT", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 10, false)) == order_result::SUCCESS);
+    REQUIRE(ob.contains(make_key(A)));
+    REQUIRE(ob.ids().size() == 1);
+}
+
+/**
+ * Resting orders keep a compact hot record for matching; the wire fields
+ * come back from the cold table with the live quantity.
+ */
+TEST_CASE("Orderbook: resting order hot/cold split", "[orderbook][pool]")
+{
+    STATIC_REQUIRE(sizeof(order_node) <= 32);
+    STATIC_REQUIRE(alignof(order_node) == 32);
+
+    orderbook ob(g_test_logger);
+
+    char IDB[16] = { 'C','O','L','D','-','B','U','Y','0','0','0','0','0','0','0','1' };
+    char IDS[16] = { 'C','O','L','D','-','S','E','L','L','0','0','0','0','0','0','1' };
+
+    REQUIRE(ob.add(make_order(7, IDB, "COLD", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 250, 10, true)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(8, IDS, "COLD", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 250, 3, false)) == order_result::SUCCESS);
+
+    auto resting = ob.resting_order(make_key(IDB));
+    REQUIRE(resting.has_value());
+    REQUIRE(resting->qty == 7);
+    REQUIRE(resting->price == 250);
+    REQUIRE(resting->timestamp == 7);
+    REQUIRE(resting->post_only);
+    REQUIRE(std::memcmp(resting->ticker, "COLD", TICKER_LEN) == 0);
+    REQUIRE(std::memcmp(resting->order_id, IDB, ORDER_ID_LEN) == 0);
+
+    REQUIRE(ob.cancel(make_key(IDB), 0) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.resting_order(make_key(IDB)).has_value());
+}
+
+/**
+ * The order ID index grows by migrating a few buckets per insert; every
+ * key must stay findable before, during and after a migration.
+ */
+TEST_CASE("order_id_index: incremental growth", "[orderbook][index]")
+{
+    order_id_index index;
+    const size_t initial = index.capacity();
+
+    auto key_of = [](uint32_t n) {
+        order_id_key k{};
+        std::snprintf(k.order_id, sizeof k.order_id, "IDX-%011u", n);
+        return k;
+    };
+
+    constexpr uint32_t N = 50000;
+    bool saw_migration = false;
+    for (uint32_t n = 1; n <= N; ++n) {
+        REQUIRE(index.insert(key_of(n), n) == order_id_index::NONE);
+        if (index.migrating()) {
+            saw_migration = true;
+            // Spot-check old and new keys while two tables are live
+            REQUIRE(index.find(key_of(1)) == 1);
+            REQUIRE(index.find(key_of(n)) == n);
+            REQUIRE(index.find(key_of(n / 2 + 1)) == n / 2 + 1);
+        }
+    }
+    REQUIRE(saw_migration);
+    REQUIRE(index.size() == N);
+    REQUIRE(index.capacity() > initial);
+    REQUIRE(index.capacity() >= 2 * N);
+
+    // Re-inserting returns the stored node and changes nothing
+    REQUIRE(index.insert(key_of(123), 999999) == 123);
+    REQUIRE(index.size() == N);
+
+    for (uint32_t n = 1; n <= N; ++n) {
+        REQUIRE(index.find(key_of(n)) == n);
+    }
+    REQUIRE(index.find(key_of(N + 1)) == order_id_index::NONE);
+
+    // Presizing avoids growth entirely
+    order_id_index sized(N);
+    const size_t cap = sized.capacity();
+    for (uint32_t n = 1; n <= N; ++n) sized.insert(key_of(n), n);
+    REQUIRE(sized.capacity() == cap);
+    REQUIRE_FALSE(sized.migrating());
+}
+
+/**
+ * Erased keys leave tombstones that lookups probe past and inserts reuse.
+ * Keys that come and go rebuild the table in place instead of growing it,
+ * and an erase during migration removes the key from both tables.
+ */
+TEST_CASE("order_id_index: erase and churn", "[orderbook][index]")
+{
+    auto key_of = [](uint32_t n) {
+        order_id_key k{};
+        std::snprintf(k.order_id, sizeof k.order_id, "ERS-%011u", n);
+        return k;
+    };
+
+    order_id_index index;
+    for (uint32_t n = 1; n <= 40; ++n) index.insert(key_of(n), n);
+    REQUIRE(index.erase(key_of(7)));
+    REQUIRE_FALSE(index.erase(key_of(7)));
+    REQUIRE(index.find(key_of(7)) == order_id_index::NONE);
+    REQUIRE(index.size() == 39);
+    // Keys whose probe chains pass the tombstone are still found
+    for (uint32_t n = 1; n <= 40; ++n) {
+        if (n != 7) REQUIRE(index.find(key_of(n)) == n);
+    }
+    // The same ID may come back with another node
+    REQUIRE(index.insert(key_of(7), 700) == order_id_index::NONE);
+    REQUIRE(index.find(key_of(7)) == 700);
+    REQUIRE(index.update(key_of(7), 701));
+    REQUIRE(index.find(key_of(7)) == 701);
+    REQUIRE_FALSE(index.update(key_of(9999), 1));
+
+    // Update and erase while two tables are live: the key's copies in both
+    // change, so it reads the same once migration finishes
+    bool erased_migrating = false;
+    for (uint32_t n = 41; n <= 5000; ++n) {
+        index.insert(key_of(n), n);
+        if (index.migrating() && !erased_migrating) {
+            REQUIRE(index.erase(key_of(1)));
+            REQUIRE(index.erase(key_of(n)));
+            REQUIRE(index.update(key_of(2), 2000000));
+            erased_migrating = true;
+        }
+    }
+    REQUIRE(erased_migrating);
+    REQUIRE_FALSE(index.migrating());
+    REQUIRE(index.find(key_of(1)) == order_id_index::NONE);
+    REQUIRE(index.find(key_of(2)) == 2000000);
+    REQUIRE(index.size() == 5000 - 2);
+
+    // A million distinct keys, at most 100 live at once
+    order_id_index churn;
+    for (uint32_t n = 1; n <= 1000000; ++n) {
+        REQUIRE(churn.insert(key_of(n), n) == order_id_index::NONE);
+        if (n > 100) REQUIRE(churn.erase(key_of(n - 100)));
+    }
+    REQUIRE(churn.size() == 100);
+    REQUIRE(churn.capacity() <= 512);
+    for (uint32_t n = 1000000 - 99; n <= 1000000; ++n) {
+        REQUIRE(churn.find(key_of(n)) == n);
+    }
+    REQUIRE(churn.find(key_of(1000000 - 100)) == order_id_index::NONE);
+}
+
+/**
+ * Every storage/sink configuration must match identically: price-time
+ * priority, partial fills, cancel and sweep across levels.
+ */
+TEMPLATE_TEST_CASE("basic_orderbook: policy configurations agree", "[orderbook][policy]",
+    (basic_orderbook<null_sink>),
+    (basic_orderbook<logger_sink, map_ladder>),
+    (basic_orderbook<null_sink, map_ladder>),
+    (basic_orderbook<callback_sink>))
+{
+    TestType ob;
+
+    char B1[16] = { 'P','O','L','I','C','Y','-','B','0','0','0','0','0','0','0','1' };
+    char B2[16] = { 'P','O','L','I','C','Y','-','B','0','0','0','0','0','0','0','2' };
+    char B3[16] = { 'P','O','L','I','C','Y','-','B','0','0','0','0','0','0','0','3' };
+    char S1[16] = { 'P','O','L','I','C','Y','-','S','0','0','0','0','0','0','0','1' };
+
+    REQUIRE(ob.add(make_order(1, B1, "PLCY", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(2, B2, "PLCY", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(3, B3, "PLCY", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 98, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.best_bid() == 100);
+
+    // Oldest at 100 fills first, then the sweep reaches 98
+    REQUIRE(ob.add(make_order(4, S1, "PLCY", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 98, 12, false)) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.contains(make_key(B1)));
+    REQUIRE_FALSE(ob.contains(make_key(B2)));
+    REQUIRE(ob.contains(make_key(B3)));
+    REQUIRE(ob.best_bid() == 98);
+    REQUIRE_FALSE(ob.best_ask().has_value());
+
+    REQUIRE(ob.cancel(make_key(B3), 0) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.best_bid().has_value());
+    REQUIRE(ob.add(make_order(5, B1, "PLCY", order_kind::LMT, order_side::BUY,
+        order_status::NEW, UINT32_MAX, 5, false)) == order_result::INVALID_PRICE);
+}
+
+/**
+ * A callback sink sees the book's events synchronously, naming orders by
+ * external ID.
+ */
+TEST_CASE("basic_orderbook: callback sink receives events", "[orderbook][policy]")
+{
+    std::vector<log_event_t> events;
+    basic_orderbook<callback_sink> ob(callback_sink([&](const log_event_t& ev) { events.push_back(ev); }));
+
+    char B1[16] = { 'C','A','L','L','B','A','C','K','-','B','0','0','0','0','0','1' };
+    char S1[16] = { 'C','A','L','L','B','A','C','K','-','S','0','0','0','0','0','1' };
+
+    REQUIRE(ob.add(make_order(1, B1, "CLBK", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 100, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.add(make_order(2, S1, "CLBK", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 100, 3, false)) == order_result::SUCCESS);
+
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].kind == log_event_kind::PRICE_LEVEL_UPDATE);
+    REQUIRE(events[1].kind == log_event_kind::TRADE_REPORT);
+    REQUIRE(events[1].qty == 3);
+    REQUIRE(events[1].id == make_key(B1));
+    REQUIRE(events[1].id_secondary == make_key(S1));
+
+    // A cancel is reported at the time of the request, not of the order
+    events.clear();
+    REQUIRE(ob.cancel(make_key(B1), 7) == order_result::SUCCESS);
+    REQUIRE(events.size() == 1);
+    REQUIRE(events[0].kind == log_event_kind::CANCEL);
+    REQUIRE(events[0].timestamp == 7);
+    REQUIRE(events[0].qty == 2);
+}
+
+/**
+ * The price range policy bounds valid prices and sizes the dense ladder;
+ * a market buy is limited at the range's top.
+ */
+TEST_CASE("basic_orderbook: static price range", "[orderbook][policy]")
+{
+    basic_orderbook<null_sink, price_ladder, static_price_range<100>> ob;
+
+    char B1[16] = { 'R','A','N','G','E','-','B','0','0','0','0','0','0','0','0','1' };
+    char S1[16] = { 'R','A','N','G','E','-','S','0','0','0','0','0','0','0','0','1' };
+    char M1[16] = { 'R','A','N','G','E','-','M','0','0','0','0','0','0','0','0','1' };
+
+    REQUIRE(ob.add(make_order(1, B1, "RNGE", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 101, 5, false)) == order_result::INVALID_PRICE);
+    REQUIRE(ob.add(make_order(2, S1, "RNGE", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 100, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.best_ask() == 100);
+    REQUIRE(ob.add(make_order(3, M1, "RNGE", order_kind::MKT, order_side::BUY,
+        order_status::NEW, 0, 5, false)) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.best_ask().has_value());
+}
+
+/**
+ * A price band indexes levels from its base in tick steps; prices outside
+ * it rest in the overflow and take part in matching like any other level.
+ */
+TEST_CASE("basic_orderbook: price band with overflow", "[orderbook][band]")
+{
+    // $500.00 .. $509.95 at five-cent ticks
+    basic_orderbook<null_sink> ob(null_sink{}, price_band{50000, 5, 200});
+
+    char B1[16] = { 'B','A','N','D','-','B','0','0','0','0','0','0','0','0','0','1' };
+    char B2[16] = { 'B','A','N','D','-','B','0','0','0','0','0','0','0','0','0','2' };
+    char B3[16] = { 'B','A','N','D','-','B','0','0','0','0','0','0','0','0','0','3' };
+    char S1[16] = { 'B','A','N','D','-','S','0','0','0','0','0','0','0','0','0','1' };
+    char S2[16] = { 'B','A','N','D','-','S','0','0','0','0','0','0','0','0','0','2' };
+    char S3[16] = { 'B','A','N','D','-','S','0','0','0','0','0','0','0','0','0','3' };
+    char X1[16] = { 'B','A','N','D','-','X','0','0','0','0','0','0','0','0','0','1' };
+
+    // Off-tick prices are rejected inside and outside the band
+    REQUIRE(ob.add(make_order(1, X1, "BAND", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 50002, 5, false)) == order_result::INVALID_PRICE);
+    REQUIRE(ob.add(make_order(1, X1, "BAND", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 49998, 5, false)) == order_result::INVALID_PRICE);
+
+    // Bids: one in the band, one below it; asks: in, above, and far above
+    REQUIRE(ob.add(make_order(2, B1, "BAND", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 49000, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.best_bid() == 49000);
+    REQUIRE(ob.add(make_order(3, B2, "BAND", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 50100, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.best_bid() == 50100);
+    REQUIRE(ob.add(make_order(4, S1, "BAND", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 60000, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.best_ask() == 60000);
+    REQUIRE(ob.add(make_order(5, S2, "BAND", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 51000, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.best_ask() == 51000);
+    REQUIRE(ob.add(make_order(6, S3, "BAND", order_kind::LMT, order_side::SELL,
+        order_status::NEW, 50500, 5, false)) == order_result::SUCCESS);
+    REQUIRE(ob.best_ask() == 50500);
+
+    // A buy sweeping all asks walks band -> overflow in price order
+    REQUIRE(ob.add(make_order(7, B3, "BAND", order_kind::LMT, order_side::BUY,
+        order_status::NEW, 60000, 12, false)) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.contains(make_key(S3)));
+    REQUIRE_FALSE(ob.contains(make_key(S2)));
+    REQUIRE(ob.resting_order(make_key(S1))->qty == 3);
+    REQUIRE(ob.best_ask() == 60000);
+
+    // Emptying the band's best bid falls back to the overflow below it
+    REQUIRE(ob.cancel(make_key(B2), 0) == order_result::SUCCESS);
+    REQUIRE(ob.best_bid() == 49000);
+    REQUIRE(ob.cancel(make_key(B1), 0) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.best_bid().has_value());
+    REQUIRE(ob.cancel(make_key(S1), 0) == order_result::SUCCESS);
+    REQUIRE_FALSE(ob.best_ask().has_value());
+}
+
+/**
+ * The ladder merges band and overflow levels when walking behind a price.
+ */
+TEST_CASE("price_ladder: next_after across band and overflow", "[orderbook][band]")
+{
+    price_ladder bids(order_side::BUY, price_band{100, 2, 10});   // 100..118
+    for (uint32_t px : { 90u, 104u, 110u, 118u, 200u }) {
+        bids.mark_occupied(px);
+        bids[px];
+    }
+    REQUIRE(bids.top() == 200);
+    REQUIRE(bids.overflow_levels() == 2);
+    REQUIRE(bids.next_after(200) == 118);
+    REQUIRE(bids.next_after(118) == 110);
+    REQUIRE(bids.next_after(104) == 90);
+    REQUIRE(bids.next_after(90) == price_ladder::NO_LEVEL);
+
+    price_ladder asks(order_side::SELL, price_band{100, 2, 10});
+    for (uint32_t px : { 90u, 104u, 200u }) {
+        asks[px];
+        asks.mark_occupied(px);
+    }
+    REQUIRE(asks.top() == 90);
+    REQUIRE(asks.next_after(90) == 104);
+    REQUIRE(asks.next_after(104) == 200);
+    asks.mark_empty(90);
+    REQUIRE(asks.top() == 104);
+    REQUIRE(asks.overflow_levels() == 1);
+}
+
+/**
+ * apply_batch() must give the same results and leave the same book as
+ * applying each order in turn, including orders that cancel or modify
+ * orders added earlier in the same batch.
+ */
+TEST_CASE("basic_orderbook: apply_batch matches sequential apply", "[orderbook][batch]")
+{
+    std::mt19937 rng(4242);
+    std::uniform_int_distribution<int> op_dist(0, 9);
+    std::uniform_int_distribution<int> px_dist(95, 105);
+    std::uniform_int_distribution<int> qty_dist(1, 20);
+
+    // Adds refer to fresh IDs; cancels and modifies pick an earlier one
+    std::vector<order_t> flow;
+    for (uint32_t n = 1; n <= 3000; ++n) {
+        char id[17];
+        std::snprintf(id, sizeof id, "BATCH-%010u", n);
+        const int op = op_dist(rng);
+        const order_side side = rng() % 2 ? order_side::BUY : order_side::SELL;
+        order_status status = order_status::NEW;
+        if (op >= 6 && n > 10) {
+            std::snprintf(id, sizeof id, "BATCH-%010u", static_cast<uint32_t>(1 + rng() % (n - 1)));
+            status = op >= 8 ? order_status::PARTIALLY_FILLED : order_status::CANCELLED;
+        }
+        flow.push_back(make_order(n, id, "BTCH", order_kind::LMT, side, status,
+                                  static_cast<uint32_t>(px_dist(rng)),
+                                  static_cast<size_t>(qty_dist(rng)), false));
+    }
+    flow.push_back(make_order(0, "BATCH-BADSTATUS", "BTCH", order_kind::LMT, order_side::BUY,
+                              static_cast<order_status>(9), 100, 1, false));
+
+    basic_orderbook<null_sink> one_by_one;
+    basic_orderbook<null_sink> batched;
+
+    std::vector<order_result> expected;
+    for (const order_t& o : flow) expected.push_back(one_by_one.apply(o));
+
+    std::vector<order_result> got(flow.size());
+    const std::span<const order_t> all(flow);
+    for (size_t at = 0; at < flow.size(); at += 37) {
+        const size_t len = std::min<size_t>(37, flow.size() - at);
+        batched.apply_batch(all.subspan(at, len), std::span<order_result>(got).subspan(at, len));
+    }
+
+    REQUIRE(got == expected);
+    REQUIRE(expected.back() == order_result::INVALID_STATUS);
+    REQUIRE(batched.best_bid() == one_by_one.best_bid());
+    REQUIRE(batched.best_ask() == one_by_one.best_ask());
+    for (const order_t& o : flow) {
+        order_id_key key;
+        std::memcpy(key.order_id, o.order_id, ORDER_ID_LEN);
+        const auto a = one_by_one.resting_order(key);
+        const auto b = batched.resting_order(key);
+        REQUIRE(a.has_value() == b.has_value());
+        if (a) {
+            REQUIRE(a->qty == b->qty);
+            REQUIRE(a->price == b->price);
+        }
+    }
+}
+
+/**
+ * Cancels and modifies are resolved through the book's ID index while
+ * the batch prefetches them, including IDs that were released and reused
+ * earlier in the same batch.
+ */
+TEST_CASE("basic_orderbook: apply_batch resolves reused IDs", "[orderbook][batch]")
+{
+    // Buys rest at or below 100 and sells above it, so nothing trades
+    std::vector<order_t> flow;
+    auto push = [&](uint32_t n, order_status status, uint32_t price, size_t qty) {
+        char id[17];
+        std::snprintf(id, sizeof id, "REUSED-ID-%06u", n);
+        flow.push_back(make_order(flow.size(), id, "REUS", order_kind::LMT,
+                                  n % 2 ? order_side::BUY : order_side::SELL, status,
+                                  n % 2 ? price : price + 10, qty, false));
+    };
+    for (uint32_t n = 0; n < 64; ++n) push(n, order_status::NEW, 100 - n % 7, 10);
+    for (uint32_t n = 0; n < 64; ++n) {
+        if (n % 3 == 0) {
+            push(n, order_status::CANCELLED, 100 - n % 7, 10);
+            push(n, order_status::NEW, 95, 5);
+        } else if (n % 3 == 1) {
+            push(n, order_status::PARTIALLY_FILLED, 100 - n % 7, 4);
+        } else {
+            push(n, order_status::PARTIALLY_FILLED, 97, 10);
+        }
+    }
+
+    basic_orderbook<null_sink> one_by_one;
+    basic_orderbook<null_sink> batched;
+
+    std::vector<order_result> expected;
+    for (const order_t& o : flow) expected.push_back(one_by_one.apply(o));
+    std::vector<order_result> got(flow.size());
+    batched.apply_batch(flow, got);
+
+    REQUIRE(got == expected);
+    REQUIRE(std::count(got.begin(), got.end(), order_result::SUCCESS) == static_cast<long>(flow.size()));
+    REQUIRE(batched.best_bid() == one_by_one.best_bid());
+    REQUIRE(batched.best_ask() == one_by_one.best_ask());
+    REQUIRE(batched.ids().size() == one_by_one.ids().size());
+}
+
+/**
+ * During apply_batch() events are held back and reach the sink in one
+ * bulk hand-off, in the same order sequential apply() produces them.
+ */
+TEST_CASE("basic_orderbook: apply_batch defers events to the end", "[orderbook][batch]")
+{
+    char B1[16] = { 'D','E','F','E','R','-','B','0','0','0','0','0','0','0','0','1' };
+    char S1[16] = { 'D','E','F','E','R','-','S','0','0','0','0','0','0','0','0','1' };
+    char S2[16] = { 'D','E','F','E','R','-','S','0','0','0','0','0','0','0','0','2' };
+    const std::vector<order_t> flow = {
+        make_order(1, B1, "DEFR", order_kind::LMT, order_side::BUY, order_status::NEW, 100, 10, false),
+        make_order(2, S1, "DEFR", order_kind::LMT, order_side::SELL, order_status::NEW, 100, 4, false),
+        make_order(3, S2, "DEFR", order_kind::LMT, order_side::SELL, order_status::NEW, 101, 5, false),
+        make_order(4, S2, "DEFR", order_kind::LMT, order_side::SELL, order_status::CANCELLED, 101, 5, false),
+    };
+
+    std::vector<log_event_kind> sequential;
+    basic_orderbook<callback_sink> one(callback_sink([&](const log_event_t& ev) { sequential.push_back(ev.kind); }));
+    for (const order_t& o : flow) one.apply(o);
+
+    // Results are written as each order is applied, so the last one is
+    // still unset while the batch runs
+    std::vector<order_result> results(flow.size(), order_result::INVALID_STATUS);
+    std::vector<log_event_kind> batched;
+    bool early = false;
+    basic_orderbook<callback_sink> many(callback_sink([&](const log_event_t& ev) {
+        if (results.back() == order_result::INVALID_STATUS) early = true;
+        batched.push_back(ev.kind);
+    }));
+    many.apply_batch(flow, results);
+
+    REQUIRE_FALSE(early);
+    REQUIRE(sequential.size() == 4);
+    REQUIRE(batched == sequential);
+}
+
+TEST_CASE("logger: binary log decodes to the JSON log", "[logger]")
+{
+    char B1[16] = { 'L','O','G','-','B','0','0','0','0','0','0','0','0','0','0','1' };
+    char S1[16] = { 'L','O','G','-','S','0','0','0','0','0','0','0','0','0','0','1' };
+
+    auto write_all = [&](logger& log) {
+        log.log_price_level_update(1, B1, 100, 10, order_side::BUY);
+        log.log_trade_report(2, B1, 100, 4, S1, 100);
+        log.log_modify_order(3, B1, 100, 10, order_side::BUY, B1, 100, 6, order_side::BUY);
+        log.log_cancel_order(4, S1, 101, 5, order_side::SELL);
+        log.log_price_level_update(5, nullptr, 0, 0, order_side::SELL);
+    };
+    {
+        logger json("test_log_format.json");
+        logger binary("test_log_format.bin", log_format::BINARY);
+        write_all(json);
+        write_all(binary);
+    }
+
+    std::ifstream expected("test_log_format.json");
+    std::stringstream want;
+    want << expected.rdbuf();
+
+    std::ifstream in("test_log_format.bin", std::ios::binary);
+    std::stringstream got;
+    REQUIRE(decode_log(in, got) == 5);
+    REQUIRE(got.str() == want.str());
+
+    // Wrong magic, and a partial record, are refused
+    std::istringstream garbage(std::string(sizeof(log_file_header_t), 'x'));
+    std::ostringstream sink;
+    REQUIRE_THROWS_AS(decode_log(garbage, sink), std::runtime_error);
+
+    std::ifstream whole("test_log_format.bin", std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(whole)), std::istreambuf_iterator<char>());
+    REQUIRE(bytes.size() == sizeof(log_file_header_t) + 5 * sizeof(log_record_t));
+    std::istringstream truncated(bytes.substr(0, bytes.size() - 1));
+    REQUIRE_THROWS_AS(decode_log(truncated, sink), std::runtime_error);
+}
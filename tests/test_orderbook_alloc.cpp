@@ -0,0 +1,254 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include "types.h"
+#include "orderbook.h"
+
+/*
+  This binary replaces the global allocation functions so a test can count
+  heap allocations made by the current thread while `t_counting` is set.
+  It lives apart from test_orderbook.cpp so the replacement only affects
+  these tests.
+*/
+namespace {
+thread_local bool t_counting = false;
+thread_local size_t t_allocs = 0;
+
+void count_alloc() {
+    if (t_counting) ++t_allocs;
+}
+}
+
+// Sanitizers bring their own malloc, which these would bypass
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define ALLOC_TEST_SANITIZED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define ALLOC_TEST_SANITIZED 1
+#endif
+#endif
+
+#if defined(__GLIBC__) && !defined(ALLOC_TEST_SANITIZED)
+// The C allocation functions are counted too: the order ID index takes its
+// tables from calloc. operator new allocates through malloc, so it is
+// counted there.
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t n);
+void* __libc_memalign(size_t align, size_t n);
+
+void* malloc(size_t n) noexcept { count_alloc(); return __libc_malloc(n); }
+void* calloc(size_t n, size_t size) noexcept { count_alloc(); return __libc_calloc(n, size); }
+void* realloc(void* p, size_t n) noexcept { count_alloc(); return __libc_realloc(p, n); }
+void* aligned_alloc(size_t align, size_t n) noexcept { count_alloc(); return __libc_memalign(align, n); }
+}
+static constexpr bool k_new_counts = false;
+#else
+static constexpr bool k_new_counts = true;
+#endif
+
+void* operator new(std::size_t n) {
+    if (k_new_counts) count_alloc();
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t n) { return ::operator new(n); }
+
+void* operator new(std::size_t n, std::align_val_t al) {
+    if (k_new_counts) count_alloc();
+    const size_t a = static_cast<size_t>(al);
+    if (void* p = std::aligned_alloc(a, (n + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t n, std::align_val_t al) { return ::operator new(n, al); }
+
+// Every delete ends in one of these two. Kept out of line so the compiler
+// never sees a pointer from operator new reach free() directly
+// (-Wmismatched-new-delete).
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { ::operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { ::operator delete(p); }
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t al) noexcept { ::operator delete(p, al); }
+void operator delete(void* p, std::size_t, std::align_val_t al) noexcept { ::operator delete(p, al); }
+void operator delete[](void* p, std::size_t, std::align_val_t al) noexcept { ::operator delete(p, al); }
+
+/**
+ * Helper to build a limit order with a numbered ID.
+ */
+static order_t make_numbered(uint64_t n, order_side side, uint32_t price, size_t qty)
+{
+    char id[ORDER_ID_LEN] = {};
+    std::snprintf(id, sizeof id, "ALLOC-%09llu", static_cast<unsigned long long>(n));
+    return order_t(n, id, "ALOC", order_kind::LMT, side, order_status::NEW,
+                   price, qty, false);
+}
+
+static order_id_key key_of(const order_t& o)
+{
+    order_id_key key;
+    std::memcpy(key.order_id, o.order_id, ORDER_ID_LEN);
+    return key;
+}
+
+/**
+ * With a capacity profile covering the live orders, adds (resting and
+ * crossing), modifies and cancels after warmup make no heap allocation,
+ * even though the session sends more distinct IDs than the profile
+ * reserves: done orders give their IDs back.
+ */
+TEST_CASE("Orderbook: no allocation in steady state with a capacity profile", "[orderbook][alloc]")
+{
+    orderbook_config_t config;
+    config.expected_live_orders = 16384;
+    config.expected_order_ids = 16384;
+    config.prefault = true;
+    orderbook ob(config);
+
+    uint64_t next_id = 1;
+    std::vector<order_id_key> resting;
+    resting.reserve(config.expected_live_orders);
+
+    // Two-sided book around 1000 with a spread
+    auto seed = [&]() {
+        for (uint32_t i = 0; i < 2000; ++i) {
+            const uint64_t n = next_id++;
+            const bool buy = i % 2 == 0;
+            const uint32_t px = buy ? 990 - (i % 50) : 1010 + (i % 50);
+            ob.add(make_numbered(n, buy ? order_side::BUY : order_side::SELL, px, 10));
+        }
+    };
+
+    // Mixed traffic: rest, cross a few levels, reprice, shrink, cancel
+    auto churn = [&](int rounds) {
+        for (int r = 0; r < rounds; ++r) {
+            const uint64_t n = next_id++;
+            const bool buy = r % 2 == 0;
+            const order_side side = buy ? order_side::BUY : order_side::SELL;
+            switch (r % 5) {
+            case 0:
+            case 1: {
+                order_t o = make_numbered(n, side, buy ? 980 + (r % 9) : 1020 - (r % 9), 5);
+                ob.add(o);
+                resting.push_back(key_of(o));
+                break;
+            }
+            case 2:
+                ob.add(make_numbered(n, side, buy ? 1030 : 970, 25));
+                break;
+            case 3:
+                if (!resting.empty()) {
+                    order_t o;
+                    const order_id_key& key = resting.back();
+                    if (auto cur = ob.resting_order(key)) {
+                        o = *cur;
+                        if ((r / 5) % 2) {
+                            o.qty = cur->qty > 1 ? cur->qty - 1 : cur->qty;
+                        } else {
+                            // one tick more passive: loses priority, never crosses
+                            o.price += static_cast<order_side>(o.side) == order_side::BUY ? -1 : 1;
+                        }
+                        ob.modify(key, o);
+                    }
+                }
+                break;
+            default:
+                if (!resting.empty()) {
+                    ob.cancel(resting.back(), 0);
+                    resting.pop_back();
+                }
+                break;
+            }
+        }
+    };
+
+    seed();
+    churn(5000);
+    seed();
+
+    t_allocs = 0;
+    t_counting = true;
+    churn(20000);
+    t_counting = false;
+
+    REQUIRE(t_allocs == 0);
+    REQUIRE(next_id > config.expected_order_ids);
+}
+
+/**
+ * expected_order_ids bounds live IDs, not IDs per session. Past it the
+ * index grows on demand.
+ */
+TEST_CASE("Orderbook: running past the reserved ID count", "[orderbook][alloc]")
+{
+    constexpr size_t LIVE = 512;
+    orderbook_config_t config;
+    config.expected_live_orders = 4 * LIVE;
+    config.expected_order_ids = 4 * LIVE;
+    config.prefault = true;
+    orderbook ob(config);
+
+    // LIVE resting buys; each new one cancels the oldest
+    std::vector<uint64_t> ring(LIVE, 0);
+    uint64_t next_id = 1;
+    auto cycle = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t n = next_id++;
+            uint64_t& slot = ring[n % LIVE];
+            if (slot != 0) {
+                REQUIRE(ob.cancel(key_of(make_numbered(slot, order_side::BUY, 0, 0)), 0) == order_result::SUCCESS);
+            }
+            REQUIRE(ob.add(make_numbered(n, order_side::BUY, 100 + static_cast<uint32_t>(n % 50), 1)) ==
+                    order_result::SUCCESS);
+            slot = n;
+        }
+    };
+
+    cycle(8 * LIVE);
+
+    t_allocs = 0;
+    t_counting = true;
+    cycle(200 * LIVE);
+    t_counting = false;
+
+    REQUIRE(t_allocs == 0);
+    REQUIRE(next_id > 50 * config.expected_order_ids);
+    REQUIRE(ob.ids().size() == LIVE);
+
+    // More live IDs than reserved: still accepted, storage grows
+    t_allocs = 0;
+    t_counting = true;
+    for (size_t i = 0; i < 8 * LIVE; ++i) {
+        REQUIRE(ob.add(make_numbered(next_id++, order_side::BUY, 100, 1)) == order_result::SUCCESS);
+    }
+    t_counting = false;
+    REQUIRE(t_allocs > 0);
+    REQUIRE(ob.ids().size() == 9 * LIVE);
+}
+
+/**
+ * Without a profile the pool and ID index grow on demand, which the
+ * counter must see (guards the test above against counting nothing).
+ */
+TEST_CASE("Orderbook: on-demand growth allocates", "[orderbook][alloc]")
+{
+    orderbook ob;
+
+    t_allocs = 0;
+    t_counting = true;
+    for (uint64_t n = 1; n <= 20000; ++n) {
+        ob.add(make_numbered(n, order_side::BUY, 100 + (n % 100), 1));
+    }
+    t_counting = false;
+
+    REQUIRE(t_allocs > 0);
+}
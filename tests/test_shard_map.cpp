@@ -0,0 +1,112 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "shard_map.h"
+
+static std::vector<uint64_t> worker_loads(const shard_map& map, const std::vector<symbol_load>& loads) {
+    std::vector<uint64_t> out(map.workers(), 0);
+    for (const auto& l : loads) out[map.worker_for(l.symbol)] += l.rate;
+    return out;
+}
+
+TEST_CASE("shard_map: unassigned symbols hash to a stable worker", "[shard_map]")
+{
+    shard_map a(7), b(7);
+    for (const char* sym : {"AAPL", "AMZN", "AMD", "MSFT", "Z"}) {
+        REQUIRE(a.worker_for(sym) < 7);
+        REQUIRE(a.worker_for(sym) == b.worker_for(sym));
+    }
+
+    a.assign("AAPL", 9);   // out of range wraps
+    REQUIRE(a.worker_for("AAPL") == 2);
+    REQUIRE(shard_map(0).workers() == 1);
+}
+
+TEST_CASE("shard_map: save and load round trip", "[shard_map]")
+{
+    const std::string path = "test_shard_map.txt";
+    shard_map map(4);
+    map.assign("AAPL", 1);
+    map.assign("MSFT", 3);
+    map.save(path);
+
+    shard_map loaded = shard_map::load(path, 4);
+    REQUIRE(loaded.assignments() == map.assignments());
+
+    {
+        std::ofstream out(path);
+        out << "# hand written\n\nAAPL 2   # hot\n  GOOG 5\n";
+    }
+    loaded = shard_map::load(path, 4);
+    REQUIRE(loaded.assignments().size() == 2);
+    REQUIRE(loaded.worker_for("AAPL") == 2);
+    REQUIRE(loaded.worker_for("GOOG") == 1);
+
+    {
+        std::ofstream out(path);
+        out << "AAPL\n";
+    }
+    REQUIRE_THROWS_AS(shard_map::load(path, 4), std::runtime_error);
+    {
+        std::ofstream out(path);
+        out << "AAPL 1 extra\n";
+    }
+    REQUIRE_THROWS_AS(shard_map::load(path, 4), std::runtime_error);
+    std::remove(path.c_str());
+
+    REQUIRE_THROWS_AS(shard_map::load("no/such/shard_map.txt"), std::runtime_error);
+}
+
+TEST_CASE("shard_map: balance spreads measured load", "[shard_map]")
+{
+    // The alphabetical split put all of these on one thread
+    std::vector<symbol_load> loads = {
+        {"AAPL", 900}, {"AMZN", 700}, {"AMD", 500}, {"ABNB", 300},
+        {"ADBE", 200}, {"AMAT", 200}, {"AXP", 100}, {"ABT", 100},
+    };
+    shard_map map = shard_map::balance(loads, 3);
+    REQUIRE(map.assignments().size() == loads.size());
+
+    const auto per_worker = worker_loads(map, loads);
+    const uint64_t total = std::accumulate(per_worker.begin(), per_worker.end(), uint64_t{0});
+    REQUIRE(total == 3000);
+    for (uint64_t l : per_worker) {
+        REQUIRE(l >= 900);
+        REQUIRE(l <= 1100);
+    }
+}
+
+TEST_CASE("shard_map: plan_moves evens out a skewed assignment", "[shard_map]")
+{
+    std::vector<symbol_load> loads = {
+        {"AAPL", 1000}, {"AMZN", 400}, {"AMD", 300}, {"ABNB", 50},
+        {"MSFT", 100},
+    };
+    shard_map map(2);
+    for (const auto& l : loads) map.assign(l.symbol, 0);
+    map.assign("MSFT", 1);
+
+    const auto moves = map.plan_moves(loads, 0.1, 8);
+    REQUIRE(!moves.empty());
+
+    // Never the hot symbol that would just move the problem
+    for (const auto& m : moves) {
+        REQUIRE(m.symbol != "AAPL");
+        REQUIRE(m.from == 0);
+        REQUIRE(m.to == 1);
+        map.assign(m.symbol, m.to);
+    }
+    const auto after = worker_loads(map, loads);
+    REQUIRE(after[0] < 1750);
+    REQUIRE(after[0] - after[1] < 1750 - 100);
+
+    // Already balanced: nothing to do
+    REQUIRE(map.plan_moves(loads, 1.0).empty());
+    REQUIRE(map.plan_moves(loads, 0.1, 0).empty());
+}
@@ -0,0 +1,46 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <thread>
+#include "spsc_ring.h"
+
+TEST_CASE("spsc_ring: bounded, ordered across wrap-around", "[spsc_ring]")
+{
+    spsc_ring<uint64_t> ring(5);
+    REQUIRE(ring.capacity() == 5);
+    for (uint64_t i = 0; i < 5; ++i) REQUIRE(ring.try_push(i));
+    REQUIRE(!ring.try_push(5));
+    REQUIRE(ring.size() == 5);
+
+    uint64_t out[16];
+    REQUIRE(ring.try_pop_bulk(out, 3) == 3);
+    REQUIRE(out[2] == 2);
+    for (uint64_t i = 5; i < 8; ++i) REQUIRE(ring.try_push(i));
+    REQUIRE(!ring.try_push(8));
+    REQUIRE(ring.try_pop_bulk(out, 16) == 5);
+    REQUIRE(out[0] == 3);
+    REQUIRE(out[4] == 7);
+    REQUIRE(ring.try_push(8));
+    REQUIRE(ring.try_pop_bulk(out, 16) == 1);
+    REQUIRE(ring.empty());
+    REQUIRE(ring.pushed() == 9);
+
+    // One producer thread, one consumer: everything arrives, in order
+    const uint64_t N = 200000;
+    std::thread producer([&] {
+        for (uint64_t i = 9; i < 9 + N; ++i) {
+            while (!ring.try_push(i)) std::this_thread::yield();
+        }
+    });
+    uint64_t expect = 9;
+    while (expect < 9 + N) {
+        const size_t n = ring.try_pop_bulk(out, 16);
+        if (n == 0) std::this_thread::yield();
+        for (size_t i = 0; i < n; ++i) {
+            if (out[i] != expect++) FAIL("out of order");
+        }
+    }
+    producer.join();
+    REQUIRE(ring.popped() == 9 + N);
+}
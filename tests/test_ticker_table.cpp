@@ -0,0 +1,36 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_all.hpp>
+#include <string>
+#include <vector>
+#include "ticker_table.h"
+
+TEST_CASE("ticker_table: keys, growth and misses", "[ticker_table]")
+{
+    REQUIRE(ticker_key("IBM") != 0);
+    REQUIRE(ticker_key("IBM") == ticker_key(std::string("IBM\0", 4)));
+    REQUIRE(ticker_key("AAPLX") == ticker_key("AAPL"));
+    REQUIRE(ticker_name(ticker_key("IBM")) == "IBM");
+    REQUIRE(ticker_name(ticker_key("AAPL")) == "AAPL");
+
+    ticker_table<uint32_t> table;
+    std::vector<ticker_key_t> keys;
+    for (char a = 'A'; a <= 'Z'; ++a) {
+        for (char b = 'A'; b <= 'Z'; ++b) {
+            const char sym[] = {a, b, 'X', '\0'};
+            keys.push_back(ticker_key(sym));
+            table.insert(keys.back(), static_cast<uint32_t>(keys.size() - 1));
+        }
+    }
+    REQUIRE(table.size() == keys.size());
+    for (uint32_t i = 0; i < keys.size(); ++i) {
+        REQUIRE(table.find(keys[i]) != nullptr);
+        REQUIRE(*table.find(keys[i]) == i);
+    }
+    REQUIRE(table.find(ticker_key("ZZZZ")) == nullptr);
+    REQUIRE(table.find(0) == nullptr);
+
+    table.insert(keys[0], 99);
+    REQUIRE(table.size() == keys.size());
+    REQUIRE(*table.find(keys[0]) == 99);
+}
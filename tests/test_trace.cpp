@@ -0,0 +1,40 @@
+#define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_all.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ticker_table.h"
+#include "trace.h"
+
+TEST_CASE("trace: per-thread rings keep the newest records", "[trace]")
+{
+    const ticker_key_t ibm = ticker_key("IBM");
+    auto mine = [&](const std::vector<trace_record>& all) {
+        std::vector<trace_record> out;
+        for (const auto& r : all) {
+            if (r.ticker == ibm) out.push_back(r);
+        }
+        return out;
+    };
+
+    // Another thread's records outlive it and keep their own thread index
+    std::thread([&] { trace_emit(trace_point::ENQUEUED, ibm, 7, 1); }).join();
+    trace_emit(trace_point::ORDER_APPLIED, ibm, 7, 0);
+    auto records = mine(trace_collect());
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].point == static_cast<uint16_t>(trace_point::ENQUEUED));
+    REQUIRE(records[1].point == static_cast<uint16_t>(trace_point::ORDER_APPLIED));
+    REQUIRE(records[0].thread != records[1].thread);
+    REQUIRE(records[0].ns <= records[1].ns);
+    REQUIRE(std::string(trace_point_name(trace_point::ORDER_APPLIED)) == "order_applied");
+
+    // A full ring overwrites its oldest records
+    std::thread([&] {
+        for (uint64_t i = 0; i < TRACE_RING_RECORDS + 10; ++i) trace_emit(trace_point::BATCH, ibm, i);
+    }).join();
+    records = mine(trace_collect());
+    REQUIRE(records.size() == 2 + TRACE_RING_RECORDS);
+    REQUIRE(records[2].a == 10);
+    REQUIRE(records.back().a == TRACE_RING_RECORDS + 9);
+}